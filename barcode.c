@@ -1,318 +1,959 @@
-// Barcode - Generates a CODE128 barcode
-// Dan Jackson, 2019
-
-#include <stdint.h>
-#include <stdbool.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-
-#include "barcode.h"
-
-typedef unsigned char barcode_symbol_t;
-
-typedef struct
-{
-    uint8_t *buffer;
-    size_t bufferSize;
-    size_t offset;
-    
-    uint32_t checksum;
-    size_t numSymbols;
-
-    barcode_code_t code;
-    bool error;
-} barcode_t;
-
-// 218 bytes
-static const uint16_t code128[107] =
-{
-    // 16-bit packed format: rwwppppppppppppp 
-    // (==0 = nothing; r = 1-bit reserved; w = 2-bits (width-10); p = 13-bit right-aligned pattern)
-    // packed hex, packed bin.,      BSBSBSbs     val  CA  CB  CC = representation (0-105 are <11 bars>)
-    0x2133, // 0b0010000100110011, 0x21222200, //   0  SP  SP  00 = 32
-    0x2193, // 0b0010000110010011, 0x22212200, //   1   !   !  01 = 33
-    0x2199, // 0b0010000110011001, 0x22222100, //   2   "   "  02 = 34
-    0x2367, // 0b0010001101100111, 0x12122300, //   3   #   #  03 = 35
-    0x2373, // 0b0010001101110011, 0x12132200, //   4   $   $  04 = 36
-    0x23B3, // 0b0010001110110011, 0x13122200, //   5   %   %  05 = 37
-    0x2337, // 0b0010001100110111, 0x12221300, //   6   &   &  06 = 38
-    0x233B, // 0b0010001100111011, 0x12231200, //   7   '   '  07 = 39
-    0x239B, // 0b0010001110011011, 0x13221200, //   8   (   (  08 = 40
-    0x21B7, // 0b0010000110110111, 0x22121300, //   9   )   )  09 = 41
-    0x21BB, // 0b0010000110111011, 0x22131200, //  10   *   *  10 = 42
-    0x21DB, // 0b0010000111011011, 0x23121200, //  11   +   +  11 = 43
-    0x2263, // 0b0010001001100011, 0x11223200, //  12   ,   ,  12 = 44
-    0x2323, // 0b0010001100100011, 0x12213200, //  13   -   -  13 = 45
-    0x2331, // 0b0010001100110001, 0x12223100, //  14   .   .  14 = 46
-    0x2233, // 0b0010001000110011, 0x11322200, //  15   /   /  15 = 47
-    0x2313, // 0b0010001100010011, 0x12312200, //  16   0   0  16 = 48
-    0x2319, // 0b0010001100011001, 0x12322100, //  17   1   1  17 = 49
-    0x218D, // 0b0010000110001101, 0x22321100, //  18   2   2  18 = 50
-    0x21A3, // 0b0010000110100011, 0x22113200, //  19   3   3  19 = 51
-    0x21B1, // 0b0010000110110001, 0x22123100, //  20   4   4  20 = 52
-    0x211B, // 0b0010000100011011, 0x21321200, //  21   5   5  21 = 53
-    0x218B, // 0b0010000110001011, 0x22311200, //  22   6   6  22 = 54
-    0x2091, // 0b0010000010010001, 0x31213100, //  23   7   7  23 = 55
-    0x20B3, // 0b0010000010110011, 0x31122200, //  24   8   8  24 = 56
-    0x20D3, // 0b0010000011010011, 0x32112200, //  25   9   9  25 = 57
-    0x20D9, // 0b0010000011011001, 0x32122100, //  26   :   :  26 = 58
-    0x209B, // 0b0010000010011011, 0x31221200, //  27   ;   ;  27 = 59
-    0x20CB, // 0b0010000011001011, 0x32211200, //  28   <   <  28 = 60
-    0x20CD, // 0b0010000011001101, 0x32221100, //  29   =   =  29 = 61
-    0x2127, // 0b0010000100100111, 0x21212300, //  30   >   >  30 = 62
-    0x2139, // 0b0010000100111001, 0x21232100, //  31   ?   ?  31 = 63
-    0x21C9, // 0b0010000111001001, 0x23212100, //  32   @   @  32 = 64
-    0x22E7, // 0b0010001011100111, 0x11132300, //  33   A   A  33 = 65
-    0x23A7, // 0b0010001110100111, 0x13112300, //  34   B   B  34 = 66
-    0x23B9, // 0b0010001110111001, 0x13132100, //  35   C   C  35 = 67
-    0x2277, // 0b0010001001110111, 0x11231300, //  36   D   D  36 = 68
-    0x2397, // 0b0010001110010111, 0x13211300, //  37   E   E  37 = 69
-    0x239D, // 0b0010001110011101, 0x13231100, //  38   F   F  38 = 70
-    0x2177, // 0b0010000101110111, 0x21131300, //  39   G   G  39 = 71
-    0x21D7, // 0b0010000111010111, 0x23111300, //  40   H   H  40 = 72
-    0x21DD, // 0b0010000111011101, 0x23131100, //  41   I   I  41 = 73
-    0x2247, // 0b0010001001000111, 0x11213300, //  42   J   J  42 = 74
-    0x2271, // 0b0010001001110001, 0x11233100, //  43   K   K  43 = 75
-    0x2391, // 0b0010001110010001, 0x13213100, //  44   L   L  44 = 76
-    0x2227, // 0b0010001000100111, 0x11312300, //  45   M   M  45 = 77
-    0x2239, // 0b0010001000111001, 0x11332100, //  46   N   N  46 = 78
-    0x2389, // 0b0010001110001001, 0x13312100, //  47   O   O  47 = 79
-    0x2089, // 0b0010000010001001, 0x31312100, //  48   P   P  48 = 80
-    0x2171, // 0b0010000101110001, 0x21133100, //  49   Q   Q  49 = 81
-    0x21D1, // 0b0010000111010001, 0x23113100, //  50   R   R  50 = 82
-    0x2117, // 0b0010000100010111, 0x21311300, //  51   S   S  51 = 83
-    0x211D, // 0b0010000100011101, 0x21331100, //  52   T   T  52 = 84
-    0x2111, // 0b0010000100010001, 0x21313100, //  53   U   U  53 = 85
-    0x20A7, // 0b0010000010100111, 0x31112300, //  54   V   V  54 = 86
-    0x20B9, // 0b0010000010111001, 0x31132100, //  55   W   W  55 = 87
-    0x20E9, // 0b0010000011101001, 0x33112100, //  56   X   X  56 = 88
-    0x2097, // 0b0010000010010111, 0x31211300, //  57   Y   Y  57 = 89
-    0x209D, // 0b0010000010011101, 0x31231100, //  58   Z   Z  58 = 90
-    0x20E5, // 0b0010000011100101, 0x33211100, //  59   [   [  59 = 91
-    0x2085, // 0b0010000010000101, 0x31411100, //  60   \   \  60 = 92
-    0x21BD, // 0b0010000110111101, 0x22141100, //  61   ]   ]  61 = 93
-    0x2075, // 0b0010000001110101, 0x43111100, //  62   ^   ^  62 = 94
-    0x22CF, // 0b0010001011001111, 0x11122400, //  63   _   _  63 = 95
-    0x22F3, // 0b0010001011110011, 0x11142200, //  64 NUL   '  64 = 96
-    0x234F, // 0b0010001101001111, 0x12112400, //  65 SOH   a  65 = 97
-    0x2379, // 0b0010001101111001, 0x12142100, //  66 STX   b  66 = 98
-    0x23D3, // 0b0010001111010011, 0x14112200, //  67 ETX   c  67 = 99
-    0x23D9, // 0b0010001111011001, 0x14122100, //  68 EOT   d  68 =100
-    0x226F, // 0b0010001001101111, 0x11221400, //  69 ENQ   e  69 =101
-    0x227B, // 0b0010001001111011, 0x11241200, //  70 ACK   f  70 =102
-    0x232F, // 0b0010001100101111, 0x12211400, //  71 BEL   g  71 =103
-    0x233D, // 0b0010001100111101, 0x12241100, //  72  BS   h  72 =104
-    0x23CB, // 0b0010001111001011, 0x14211200, //  73  HT   i  73 =105
-    0x23CD, // 0b0010001111001101, 0x14221100, //  74  LF   j  74 =106
-    0x21ED, // 0b0010000111101101, 0x24121100, //  75  VT   k  75 =107
-    0x21AF, // 0b0010000110101111, 0x22111400, //  76  FF   l  76 =108
-    0x2045, // 0b0010000001000101, 0x41311100, //  77  CR   m  77 =109
-    0x21EB, // 0b0010000111101011, 0x24111200, //  78  SO   n  78 =110
-    0x2385, // 0b0010001110000101, 0x13411100, //  79  SI   o  79 =111
-    0x22C3, // 0b0010001011000011, 0x11124200, //  80 DLE   p  80 =112
-    0x2343, // 0b0010001101000011, 0x12114200, //  81 DC1   q  81 =113
-    0x2361, // 0b0010001101100001, 0x12124100, //  82 DC2   r  82 =114
-    0x221B, // 0b0010001000011011, 0x11421200, //  83 DC3   s  83 =115
-    0x230B, // 0b0010001100001011, 0x12411200, //  84 DC4   t  84 =116
-    0x230D, // 0b0010001100001101, 0x12421100, //  85 NAK   u  85 =117
-    0x205B, // 0b0010000001011011, 0x41121200, //  86 SYN   v  86 =118
-    0x206B, // 0b0010000001101011, 0x42111200, //  87 ETB   w  87 =119
-    0x206D, // 0b0010000001101101, 0x42121100, //  88 CAN   x  88 =120
-    0x2121, // 0b0010000100100001, 0x21214100, //  89  EM   y  89 =121
-    0x2109, // 0b0010000100001001, 0x21412100, //  90 SUB   z  90 =122
-    0x2049, // 0b0010000001001001, 0x41212100, //  91 ESC   {  91 =123
-    0x2287, // 0b0010001010000111, 0x11114300, //  92  FS   |  92 =124
-    0x22E1, // 0b0010001011100001, 0x11134100, //  93  GS   }  93 =125
-    0x23A1, // 0b0010001110100001, 0x13114100, //  94  RS   ~  94 =126
-    0x2217, // 0b0010001000010111, 0x11411300, //  95  US DEL  95 =127
-    0x221D, // 0b0010001000011101, 0x11431100, //  96 _F3 _F3  96 =128 _F3="FNC 3"
-    0x2057, // 0b0010000001010111, 0x41111300, //  97 _F2 _F2  97 =129 _F2="FNC 2"
-    0x205D, // 0b0010000001011101, 0x41131100, //  98 _SH _SH  98 =130 _SH="SHIFT"
-    0x2221, // 0b0010001000100001, 0x11314100, //  99 _CC _CC  99 =131 _CC="CODE C"
-    0x2211, // 0b0010001000010001, 0x11413100, // 100 _CB _F4 _CB =132 _CB="CODE B" _F4="FNC 4"
-    0x20A1, // 0b0010000010100001, 0x31114100, // 101 _F4 _CA _CA =133 _F4="FNC 4" _CA="CODE A"
-    0x2051, // 0b0010000001010001, 0x41113100, // 102 _F1 _F1 _F1 =134 _F1="FNC 1"
-    0x217B, // 0b0010000101111011, 0x21141200, // 103 _SA _SA _SA =135 _SA="START (Code A)"
-    0x216F, // 0b0010000101101111, 0x21121400, // 104 _SB _SB _SB =136 _SB="START (Code B)"
-    0x2163, // 0b0010000101100011, 0x21123200, // 105 _SC _SC _SC =137 _SC="START (Code C)"
-    0x6714, // 0b0110011100010100, 0x23311120, // 106 _ST _ST _ST =138 _ST="STOP" <13 bars>
-    //0x03FF, // 0b0000001111111111, 0x0000000A, // 107 _QZ _QZ _QZ =139 _QZ="QUIET" <10 bars>
-    //0x0000, // 0b0000000000000000, 0x00000000, // 108 _NO _NO _NO =140 _NO=(none) <0 bars>
-};
-
-static void BarcodeWriteBits(barcode_t *barcode, uint16_t pattern, int width)
-{
-    for (int i = width - 1; i >= 0; i--)
-    {
-        int byteOffset = (int)barcode->offset / 8;
-//printf("%d %d/%d %s\n", i, byteOffset, barcode->bufferSize, barcode->error ? "ERROR" : "OK");
-        if (byteOffset < barcode->bufferSize)
-        {
-            uint8_t *p = barcode->buffer + byteOffset;
-            bool bit = (pattern & (1 << (i & 15))) != 0;
-#ifdef BARCODE_MSB_FIRST
-            uint8_t mask = (1 << (7 - (barcode->offset & 7)));
-#else
-            uint8_t mask = (1 << (barcode->offset & 7));
-#endif
-            if (bit)
-            {
-                *p |= mask;
-            }
-            else
-            {
-                *p &= ~mask;
-            }
-            barcode->offset++;
-        }
-        else
-        {
-            barcode->error = true;
-        }
-    }
-}
-
-static void BarcodeAppendSymbol(barcode_t *barcode, barcode_symbol_t symbol)
-{
-    if (barcode->error || barcode->code == BARCODE_CODE_STOP)
-    {
-        barcode->error = true;
-        return;
-    }
-
-    // 16-bit packed format: rwwppppppppppppp 
-    // (==0 = nothing; r = 1-bit reserved; w = 2-bits (width-10); p = 13-bit right-aligned pattern)
-    // packed hex, packed bin.,      BSBSBSbs     val  CA  CB  CC = representation
-    uint16_t pattern = code128[symbol];
-    //bool reserved = (pattern & 0x8000) != 0;
-    int width = 10 + ((pattern >> 13) & 0x03);
-    BarcodeWriteBits(barcode, pattern, width);
-
-    // Update checksum
-    // checksum = SUM<(i+1) * X[i]> % 103
-    barcode->checksum += (barcode->numSymbols ? (uint32_t)barcode->numSymbols : 1) * (uint32_t)symbol;
-    barcode->checksum %= 103;
-    barcode->numSymbols++;
-}
-
-static void BarcodeChangeCode(barcode_t *barcode, barcode_code_t newCode)
-{
-    if (barcode->error || barcode->code == newCode) return;
-    if (barcode->code == BARCODE_CODE_STOP || newCode == BARCODE_CODE_NONE || newCode == BARCODE_CODE_STOP)
-    {
-        barcode->error = true;
-        return;
-    }
-
-    if (barcode->code == BARCODE_CODE_NONE)
-    {
-        switch (newCode)
-        {
-            case BARCODE_CODE_A: BarcodeAppendSymbol(barcode, 103); break;  // START (Code A)
-            case BARCODE_CODE_B: BarcodeAppendSymbol(barcode, 104); break;  // START (Code B)
-            case BARCODE_CODE_C: BarcodeAppendSymbol(barcode, 105); break;  // START (Code C)
-            default: barcode->error = true; break;
-        }
-    }
-    else
-    {
-        switch (newCode)
-        {
-            case BARCODE_CODE_A: BarcodeAppendSymbol(barcode, 101); break;  // (switch) CODE A
-            case BARCODE_CODE_B: BarcodeAppendSymbol(barcode, 100); break;  // (switch) CODE B
-            case BARCODE_CODE_C: BarcodeAppendSymbol(barcode, 99); break;   // (switch) CODE C
-            default: barcode->error = true; break;
-        }
-    }
-    barcode->code = newCode;
-}
-
-static void BarcodeStop(barcode_t *barcode)
-{
-    // Do nothing if already stopped
-    if (barcode->code == BARCODE_CODE_STOP) return;
-
-    // Empty barcodes are barcodes too!
-    if (barcode->code == BARCODE_CODE_NONE)
-    {
-        BarcodeChangeCode(barcode, BARCODE_CODE_B); // will generate start
-    }
-    
-    BarcodeAppendSymbol(barcode, (barcode_symbol_t)barcode->checksum);
-
-    // Add stop symbol
-    BarcodeAppendSymbol(barcode, 106);
-    barcode->code = BARCODE_CODE_STOP;
-}
-
-// Initialize a barcode object, using the specified bitmap buffer and its size (in bytes)
-void BarcodeInit(barcode_t *barcode, uint8_t *buffer, size_t bufferSize)
-{
-    memset(barcode, 0, sizeof(barcode_t));
-    barcode->buffer = buffer;
-    barcode->bufferSize = bufferSize;
-    barcode->code = BARCODE_CODE_NONE;
-    barcode->numSymbols = 0;
-    barcode->error = false;
-}
-
-// Append the specified string to the barcode
-void BarcodeAppend(barcode_t *barcode, const char *text, barcode_code_t fixedCode)
-{
-    for (const char *p = text; *p != '\0'; p++)
-    {
-        char c0 = p[0];
-        char c1 = p[1];
-        char c2 = c1 != 0 ? p[2] : 0;
-        char c3 = c2 != 0 ? p[3] : 0;
-        
-        barcode_code_t requiredCode = BARCODE_CODE_NONE;
-        if (c0 < 0) { barcode->error = true; continue; }
-        if (c0 >= 0 && c0 < 32) requiredCode = BARCODE_CODE_A;
-        if (c0 >= '\'' && c0 <= 0x7f) requiredCode = BARCODE_CODE_B;
-
-        if (fixedCode != BARCODE_CODE_NONE) requiredCode = fixedCode;
-
-        // Code C if there are two numerical digits, but not if we're already in another code and there isn't a third and fourth.
-        if (c0 != 0 && c1 != 0 && isdigit(c0) && isdigit(c1) && !((!isdigit(c2) || !isdigit(c3)) && (barcode->code == BARCODE_CODE_A || barcode->code == BARCODE_CODE_B)) && fixedCode == BARCODE_CODE_NONE)
-        {
-            BarcodeChangeCode(barcode, BARCODE_CODE_C);
-            BarcodeAppendSymbol(barcode, (barcode_symbol_t)( (c0 - '0') * 10 + (c1 - '0') ));  // Code C double digits
-            p++;        // consume two numbers
-        }
-        else
-        {
-            if (requiredCode != BARCODE_CODE_NONE)
-            {
-                BarcodeChangeCode(barcode, requiredCode);
-            }
-            else
-            {
-                BarcodeChangeCode(barcode, BARCODE_CODE_B);
-            }
-
-            if (c0 < 32)
-            {
-                BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c0 + 64));  // Code A
-            }
-            else
-            {
-                BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c0 - 32));  // Code B
-            }
-        }
-    }
-}
-
-
-// Writes the barcode as a bitmap (0=black, 1=white) using the specified buffer, returns the length in bars/bits. Optionally adds a 10-unit quiet zone either side.
-size_t Barcode(uint8_t *buffer, size_t bufferSize, int quietZone, const char *text, barcode_code_t fixedCode)
-{
-    barcode_t barcode;
-    BarcodeInit(&barcode, buffer, bufferSize);
-    BarcodeWriteBits(&barcode, 0xffff, quietZone);
-    BarcodeAppend(&barcode, text, fixedCode);
-    BarcodeStop(&barcode);
-    BarcodeWriteBits(&barcode, 0xffff, quietZone);
-    return barcode.offset;
-}
+// Barcode - Generates a CODE128 barcode
+// Dan Jackson, 2019
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "barcode.h"
+#include "barcode_code128.h"
+
+typedef unsigned char barcode_symbol_t;
+
+
+// 512 bytes
+static const uint8_t code128Reverse[512] =
+{
+    // Symbol value for the pattern of an 11-bar symbol (the first 11 of the stop symbol), indexed by its middle 9 bars (the first is always black, the last always white), 0xff = invalid
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0x4d, 0xff, 0x5b, 0xff, 0xff, 0xff, 0x66, 0xff, 0xff, 0x61, 0xff, 0x56, 0x62, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x57, 0x58, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0x3c, 0xff, 0x30, 0xff, 0xff, 0xff, 0x17, 0xff, 0xff, 0x39, 0xff, 0x1b, 0x3a, 0xff,
+    0x65, 0xff, 0xff, 0x36, 0xff, 0xff, 0xff, 0xff, 0xff, 0x18, 0xff, 0xff, 0x37, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x1c, 0x1d, 0xff, 0xff, 0x19, 0xff, 0xff, 0x1a, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0x3b, 0xff, 0x38, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0x5a, 0xff, 0xff, 0xff, 0x35, 0xff, 0xff, 0x33, 0xff, 0x15, 0x34, 0xff,
+    0x59, 0xff, 0xff, 0x1e, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0x1f, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x69, 0xff, 0xff, 0xff, 0xff, 0xff, 0x68, 0x31, 0xff, 0xff, 0x27, 0xff, 0x67, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x16, 0x12, 0xff, 0xff, 0x01, 0xff, 0xff, 0x02, 0xff, 0xff, 0xff,
+    0xff, 0x13, 0xff, 0xff, 0xff, 0xff, 0xff, 0x4c, 0x14, 0xff, 0xff, 0x09, 0xff, 0x0a, 0x3d, 0xff,
+    0xff, 0xff, 0x6a, 0xff, 0x20, 0xff, 0xff, 0xff, 0x32, 0xff, 0xff, 0x28, 0xff, 0x0b, 0x29, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x4e, 0x4b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x64, 0xff, 0xff, 0x5f, 0xff, 0x53, 0x60, 0xff,
+    0x63, 0xff, 0xff, 0x2d, 0xff, 0xff, 0xff, 0xff, 0xff, 0x0f, 0xff, 0xff, 0x2e, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x2a, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0c, 0xff, 0xff, 0xff, 0xff, 0xff, 0x45, 0x2b, 0xff, 0xff, 0x24, 0xff, 0x46, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x5c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x50, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x5d, 0xff, 0xff, 0x21, 0xff, 0xff, 0xff, 0xff, 0xff, 0x40, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x54, 0x55, 0xff, 0xff, 0x10, 0xff, 0xff, 0x11, 0xff, 0xff, 0xff,
+    0xff, 0x0d, 0xff, 0xff, 0xff, 0xff, 0xff, 0x47, 0x0e, 0xff, 0xff, 0x06, 0xff, 0x07, 0x48, 0xff,
+    0xff, 0x51, 0xff, 0xff, 0xff, 0xff, 0xff, 0x41, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x52, 0xff, 0xff, 0x03, 0xff, 0xff, 0xff, 0xff, 0xff, 0x04, 0xff, 0xff, 0x42, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0x4f, 0xff, 0x2f, 0xff, 0xff, 0xff, 0x2c, 0xff, 0xff, 0x25, 0xff, 0x08, 0x26, 0xff,
+    0x5e, 0xff, 0xff, 0x22, 0xff, 0xff, 0xff, 0xff, 0xff, 0x05, 0xff, 0xff, 0x23, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x49, 0x4a, 0xff, 0xff, 0x43, 0xff, 0xff, 0x44, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+// Writes the whole 32-bit words held in the accumulator to the buffer
+static inline void BarcodeFlushWords(barcode_t *barcode)
+{
+    while (barcode->numBits >= 32)
+    {
+        uint8_t *p = barcode->buffer + ((barcode->offset - barcode->numBits) >> 3);
+#ifdef BARCODE_MSB_FIRST
+        uint32_t word = (uint32_t)(barcode->bits >> (barcode->numBits - 32));
+        p[0] = (uint8_t)(word >> 24); p[1] = (uint8_t)(word >> 16); p[2] = (uint8_t)(word >> 8); p[3] = (uint8_t)word;
+#else
+        uint32_t word = (uint32_t)barcode->bits;
+        p[0] = (uint8_t)word; p[1] = (uint8_t)(word >> 8); p[2] = (uint8_t)(word >> 16); p[3] = (uint8_t)(word >> 24);
+        barcode->bits >>= 32;
+#endif
+        barcode->numBits -= 32;
+    }
+}
+
+// Writes any remaining bits held in the accumulator to the buffer (the unused bits of a final partial byte are preserved)
+static void BarcodeFlush(barcode_t *barcode)
+{
+    if (barcode->buffer == NULL) return;
+    BarcodeFlushWords(barcode);
+    uint8_t *p = barcode->buffer + ((barcode->offset - barcode->numBits) >> 3);
+    while (barcode->numBits > 0)
+    {
+        int count = barcode->numBits < 8 ? barcode->numBits : 8;
+#ifdef BARCODE_MSB_FIRST
+        uint8_t value = (uint8_t)((barcode->bits >> (barcode->numBits - count)) << (8 - count));
+        uint8_t mask = (uint8_t)(0xff << (8 - count));
+#else
+        uint8_t value = (uint8_t)(barcode->bits & ((1u << count) - 1));
+        uint8_t mask = (uint8_t)((1u << count) - 1);
+        barcode->bits >>= count;
+#endif
+        *p = (*p & ~mask) | value;
+        p++;
+        barcode->numBits -= count;
+    }
+    barcode->bits = 0;
+}
+
+// Emits up to 16 bits (the least significant 'width' bits of 'pattern', most significant first) through the accumulator
+static inline void BarcodeEmitBits(barcode_t *barcode, uint16_t pattern, int width)
+{
+    uint32_t value = pattern & ((1u << width) - 1);
+#ifdef BARCODE_MSB_FIRST
+    barcode->bits = (barcode->bits << width) | value;
+#else
+    // Reverse the bit order so the first bar is in the least significant bit
+    value = ((value & 0x5555) << 1) | ((value >> 1) & 0x5555);
+    value = ((value & 0x3333) << 2) | ((value >> 2) & 0x3333);
+    value = ((value & 0x0f0f) << 4) | ((value >> 4) & 0x0f0f);
+    value = ((value & 0x00ff) << 8) | ((value >> 8) & 0x00ff);
+    value >>= 16 - width;
+    barcode->bits |= (uint64_t)value << barcode->numBits;
+#endif
+    barcode->numBits += width;
+    barcode->offset += width;
+    if (barcode->numBits >= 32) BarcodeFlushWords(barcode);
+}
+
+// Extends the run widths with bars/bits of one color (even runs are light/spaces, odd runs are dark/bars)
+static void BarcodeAddRun(barcode_t *barcode, bool light, int width)
+{
+    size_t index = barcode->numRuns > 0 ? barcode->numRuns - 1 : 0;
+    if (barcode->numRuns == 0 || ((index & 1) == 0) != light)
+    {
+        index = barcode->numRuns + ((barcode->numRuns == 0 && !light) ? 1 : 0);
+        if (index >= barcode->maxRuns)
+        {
+            barcode->error = true;
+            return;
+        }
+        if (index > barcode->numRuns) barcode->runs[barcode->numRuns] = 0;     // Zero-width leading space
+        barcode->runs[index] = 0;
+        barcode->numRuns = index + 1;
+    }
+    barcode->runs[index] += (uint16_t)width;
+}
+
+// Writes the bars/bits of a pattern as run widths
+static void BarcodeWriteRuns(barcode_t *barcode, uint16_t pattern, int width)
+{
+    for (int i = width - 1; i >= 0; )
+    {
+        bool light = (pattern & (1 << (i & 15))) != 0;
+        int start = i;
+        while (--i >= 0 && ((pattern & (1 << (i & 15))) != 0) == light) { }
+        BarcodeAddRun(barcode, light, start - i);
+    }
+}
+
+static void BarcodeWriteBits(barcode_t *barcode, uint16_t pattern, int width)
+{
+    if (width <= 0) return;
+
+    // Only measuring, or writing run widths
+    if (barcode->buffer == NULL)
+    {
+        if (barcode->runs != NULL) BarcodeWriteRuns(barcode, pattern, width);
+        barcode->offset += width;
+        return;
+    }
+
+    // Truncate at the end of the buffer
+    size_t available = barcode->bufferSize * 8 - barcode->offset;
+    if ((size_t)width > available)
+    {
+        barcode->error = true;
+        if (available == 0) return;
+        // Only the leading bits fit
+        if (width <= 16) pattern >>= (width - (int)available);
+        width = (int)available;
+    }
+
+    // Wider than the pattern (e.g. quiet zones), the pattern bits repeat
+    int count = width & 15;
+    if (count == 0) count = 16;
+    for (; width > 0; width -= count, count = 16)
+    {
+        BarcodeEmitBits(barcode, pattern, count);
+    }
+}
+
+static void BarcodeAppendSymbol(barcode_t *barcode, barcode_symbol_t symbol)
+{
+    if (barcode->error || barcode->code == BARCODE_CODE_STOP)
+    {
+        barcode->error = true;
+        return;
+    }
+
+    // 16-bit packed format: rwwppppppppppppp 
+    // (==0 = nothing; r = 1-bit reserved; w = 2-bits (width-10); p = 13-bit right-aligned pattern)
+    // packed hex, packed bin.,      BSBSBSbs     val  CA  CB  CC = representation
+    uint16_t pattern = code128[symbol];
+    //bool reserved = (pattern & 0x8000) != 0;
+    int width = 10 + ((pattern >> 13) & 0x03);
+    BarcodeWriteBits(barcode, pattern, width);
+
+    // Update checksum
+    // checksum = SUM<(i+1) * X[i]> % 103
+    barcode->checksum += (barcode->numSymbols ? (uint32_t)barcode->numSymbols : 1) * (uint32_t)symbol;
+    barcode->checksum %= 103;
+    barcode->numSymbols++;
+}
+
+static void BarcodeChangeCode(barcode_t *barcode, barcode_code_t newCode)
+{
+    if (barcode->error || barcode->code == newCode) return;
+    if (barcode->code == BARCODE_CODE_STOP || newCode == BARCODE_CODE_NONE || newCode == BARCODE_CODE_STOP)
+    {
+        barcode->error = true;
+        return;
+    }
+
+    if (barcode->code == BARCODE_CODE_NONE)
+    {
+        switch (newCode)
+        {
+            case BARCODE_CODE_A: BarcodeAppendSymbol(barcode, 103); break;  // START (Code A)
+            case BARCODE_CODE_B: BarcodeAppendSymbol(barcode, 104); break;  // START (Code B)
+            case BARCODE_CODE_C: BarcodeAppendSymbol(barcode, 105); break;  // START (Code C)
+            default: barcode->error = true; break;
+        }
+    }
+    else
+    {
+        switch (newCode)
+        {
+            case BARCODE_CODE_A: BarcodeAppendSymbol(barcode, 101); break;  // (switch) CODE A
+            case BARCODE_CODE_B: BarcodeAppendSymbol(barcode, 100); break;  // (switch) CODE B
+            case BARCODE_CODE_C: BarcodeAppendSymbol(barcode, 99); break;   // (switch) CODE C
+            default: barcode->error = true; break;
+        }
+        barcode->numCodeChanges++;
+    }
+    barcode->code = newCode;
+}
+
+static void BarcodeStop(barcode_t *barcode)
+{
+    // Do nothing if already stopped
+    if (barcode->code == BARCODE_CODE_STOP) return;
+
+    // Empty barcodes are barcodes too!
+    if (barcode->code == BARCODE_CODE_NONE)
+    {
+        BarcodeChangeCode(barcode, BARCODE_CODE_B); // will generate start
+    }
+    
+    BarcodeAppendSymbol(barcode, (barcode_symbol_t)barcode->checksum);
+
+    // Add stop symbol
+    BarcodeAppendSymbol(barcode, 106);
+    barcode->code = BARCODE_CODE_STOP;
+}
+
+// Initialize a barcode object to write a bitmap, or run widths, or (if neither) only measure, and start with the quiet zone
+static void BarcodeStart(barcode_t *barcode, uint8_t *buffer, size_t bufferSize, uint16_t *runs, size_t maxRuns, int quietZone, barcode_code_t fixedCode)
+{
+    memset(barcode, 0, sizeof(barcode_t));
+    barcode->buffer = buffer;
+    barcode->bufferSize = bufferSize;
+    barcode->runs = runs;
+    barcode->maxRuns = maxRuns;
+    barcode->quietZone = quietZone;
+    barcode->fixedCode = (fixedCode == BARCODE_CODE_OPTIMAL) ? BARCODE_CODE_NONE : fixedCode;     // (the optimal coding requires the whole text)
+    barcode->code = BARCODE_CODE_NONE;
+    barcode->numSymbols = 0;
+    barcode->error = false;
+    BarcodeWriteBits(barcode, 0xffff, quietZone);
+}
+
+// Initialize a barcode object for incremental encoding, using the specified bitmap buffer and its size (in bytes), or NULL to only measure
+void BarcodeInit(barcode_t *barcode, uint8_t *buffer, size_t bufferSize, int quietZone, barcode_code_t fixedCode)
+{
+    BarcodeStart(barcode, buffer, bufferSize, NULL, 0, quietZone, fixedCode);
+}
+
+#define BARCODE_OPTIMAL_IMPOSSIBLE 0x3fffffff
+#define BARCODE_OPTIMAL_UNAVAILABLE 0xffff     // (as an impossible cost held in the table)
+
+// The number of symbols to encode text[i..length) without a code change, when in each of code A/B/C, given the (optimal) costs from the following two positions
+static void BarcodeOptimalDirect(const char *text, size_t length, size_t i, const uint32_t *next1, const uint32_t *next2, uint32_t *direct)
+{
+    unsigned char c = (unsigned char)text[i];
+    bool inA = c < 96;
+    bool inB = c >= 32 && c < 128;
+    direct[0] = inA ? 1 + next1[0] : (inB ? 2 + next1[0] : BARCODE_OPTIMAL_IMPOSSIBLE);   // SHIFT for a Code B character
+    direct[1] = inB ? 1 + next1[1] : (inA ? 2 + next1[1] : BARCODE_OPTIMAL_IMPOSSIBLE);   // SHIFT for a Code A character
+    direct[2] = (i + 1 < length && isdigit(c) && isdigit((unsigned char)text[i + 1])) ? 1 + next2[2] : BARCODE_OPTIMAL_IMPOSSIBLE;
+}
+
+// The number of symbols to encode text[i..length) when in each of code A/B/C, allowing a code change
+static void BarcodeOptimalCost(const uint32_t *direct, uint32_t *cost)
+{
+    for (int s = 0; s < 3; s++)
+    {
+        uint32_t change = 1 + (direct[(s + 1) % 3] < direct[(s + 2) % 3] ? direct[(s + 1) % 3] : direct[(s + 2) % 3]);
+        cost[s] = direct[s] < change ? direct[s] : change;
+        if (cost[s] > BARCODE_OPTIMAL_IMPOSSIBLE) cost[s] = BARCODE_OPTIMAL_IMPOSSIBLE;
+    }
+}
+
+// The costs held in the table for a position
+static void BarcodeOptimalLoad(const uint16_t *held, uint32_t *cost)
+{
+    for (int s = 0; s < 3; s++) cost[s] = (held[s] == BARCODE_OPTIMAL_UNAVAILABLE) ? BARCODE_OPTIMAL_IMPOSSIBLE : held[s];
+}
+
+// Append the specified string to the barcode using the fewest symbols: a shortest path over (position, code) choosing code changes and SHIFT.
+// The costs of every position are found in a single backwards pass into a fixed table, so no allocation is required; longer text is coded automatically.
+void BarcodeAppendOptimal(barcode_t *barcode, const char *text, size_t length)
+{
+    if (length > BARCODE_OPTIMAL_MAX_LENGTH)
+    {
+        BarcodeAppend(barcode, text, length);
+        return;
+    }
+
+    uint16_t table[BARCODE_OPTIMAL_MAX_LENGTH + 2][3];
+    uint32_t next1[3] = {0, 0, 0};
+    uint32_t next2[3] = {0, 0, 0};
+    for (size_t i = length + 1; i-- > 0; )
+    {
+        uint32_t cost[3] = {0, 0, 0};
+        if (i < length)
+        {
+            uint32_t direct[3];
+            BarcodeOptimalDirect(text, length, i, next1, next2, direct);
+            BarcodeOptimalCost(direct, cost);
+        }
+        for (int s = 0; s < 3; s++) table[i][s] = (cost[s] >= BARCODE_OPTIMAL_UNAVAILABLE) ? BARCODE_OPTIMAL_UNAVAILABLE : (uint16_t)cost[s];
+        memcpy(next2, next1, sizeof(next1));
+        memcpy(next1, cost, sizeof(cost));
+    }
+    memcpy(table[length + 1], table[length], sizeof(table[length]));   // (beyond the end, only for a pair of digits that cannot be formed)
+
+    for (size_t i = 0; i < length && !barcode->error; )
+    {
+        BarcodeOptimalLoad(table[i + 1], next1);
+        BarcodeOptimalLoad(table[i + 2], next2);
+        uint32_t direct[3];
+        BarcodeOptimalDirect(text, length, i, next1, next2, direct);
+
+        // Choose the code: stay in the current code unless a change is strictly better (the start symbol is preferred as Code B, then A, then C)
+        int current = (barcode->code >= BARCODE_CODE_A && barcode->code <= BARCODE_CODE_C) ? (int)(barcode->code - BARCODE_CODE_A) : -1;
+        static const int preference[3] = { 1, 0, 2 };
+        int best = current;
+        for (int p = 0; p < 3; p++)
+        {
+            int s = preference[p];
+            if (best < 0 || direct[s] + (s != current ? 1 : 0) < direct[best] + (best != current ? 1 : 0)) best = s;
+        }
+        if (direct[best] >= BARCODE_OPTIMAL_IMPOSSIBLE)
+        {
+            barcode->error = true;
+            break;
+        }
+        BarcodeChangeCode(barcode, (barcode_code_t)(BARCODE_CODE_A + best));
+
+        char c = text[i];
+        if (best == 2)
+        {
+            BarcodeAppendSymbol(barcode, (barcode_symbol_t)( (c - '0') * 10 + (text[i + 1] - '0') ));  // Code C double digits
+            i += 2;
+        }
+        else
+        {
+            bool inCurrent = (best == 0) ? ((unsigned char)c < 96) : (c >= 32);
+            if (!inCurrent) { BarcodeAppendSymbol(barcode, 98); barcode->numCodeChanges++; }  // SHIFT (single character from the other of Code A/B)
+            if (c < 32)
+            {
+                BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c + 64));  // Code A
+            }
+            else
+            {
+                BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c - 32));  // Code B
+            }
+            i++;
+        }
+    }
+}
+
+
+#define BARCODE_IS_DIGIT(_c) ((_c) >= '0' && (_c) <= '9')
+
+// Encodes the next character (or pair of digits in Code C), given the following characters for the look-ahead (c[0..BARCODE_LOOKAHEAD], NUL beyond the end of the text), returns the number of characters used
+static size_t BarcodeEncodeNext(barcode_t *barcode, const char *c)
+{
+    char c0 = c[0];
+    char c1 = c[1];
+    char c2 = c[2];
+    char c3 = c[3];
+    barcode_code_t fixedCode = barcode->fixedCode;
+
+    barcode_code_t requiredCode = BARCODE_CODE_NONE;
+    if (c0 < 0) { barcode->error = true; return 1; }
+    if (c0 >= 0 && c0 < 32) requiredCode = BARCODE_CODE_A;
+    if (c0 >= '\'' && c0 <= 0x7f) requiredCode = BARCODE_CODE_B;
+
+    if (fixedCode != BARCODE_CODE_NONE) requiredCode = fixedCode;
+
+    // A fixed code must be able to represent the character (Code C only pairs of digits)
+    if ((fixedCode == BARCODE_CODE_A && c0 >= 96) || (fixedCode == BARCODE_CODE_B && c0 < 32) || (fixedCode == BARCODE_CODE_C && !(BARCODE_IS_DIGIT(c0) && BARCODE_IS_DIGIT(c1)))) { barcode->error = true; return 1; }
+
+    // Code C if there are two numerical digits, but not if we're already in another code and there isn't a third and fourth.
+    if (BARCODE_IS_DIGIT(c0) && BARCODE_IS_DIGIT(c1) && !((!BARCODE_IS_DIGIT(c2) || !BARCODE_IS_DIGIT(c3)) && (barcode->code == BARCODE_CODE_A || barcode->code == BARCODE_CODE_B)) && (fixedCode == BARCODE_CODE_NONE || fixedCode == BARCODE_CODE_C))
+    {
+        BarcodeChangeCode(barcode, BARCODE_CODE_C);
+        BarcodeAppendSymbol(barcode, (barcode_symbol_t)( (c0 - '0') * 10 + (c1 - '0') ));  // Code C double digits
+        return 2;   // consume two numbers
+    }
+
+    if (requiredCode != BARCODE_CODE_NONE)
+    {
+        BarcodeChangeCode(barcode, requiredCode);
+    }
+    else
+    {
+        BarcodeChangeCode(barcode, BARCODE_CODE_B);
+    }
+
+    if (c0 < 32)
+    {
+        BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c0 + 64));  // Code A (including NUL)
+    }
+    else
+    {
+        BarcodeAppendSymbol(barcode, (barcode_symbol_t)(c0 - 32));  // Code B
+    }
+    return 1;
+}
+
+// Append a span of text (of any length, and may include NUL) to the barcode.  The last few characters are held back until the following characters are known (or the barcode is finished), so the look-ahead continues across spans.
+void BarcodeAppend(barcode_t *barcode, const char *text, size_t length)
+{
+    size_t i = 0;
+
+    // Characters held back from previous spans are encoded with the look-ahead topped up from the start of this one, until they are used and the span can be encoded directly
+    while (barcode->numPending > 0 && i < length)
+    {
+        int held = barcode->numPending;
+        size_t taken = 0;
+        while (barcode->numPending <= BARCODE_LOOKAHEAD && i + taken < length) barcode->pending[barcode->numPending++] = text[i + taken++];
+        if (barcode->numPending <= BARCODE_LOOKAHEAD) { i += taken; break; }     // (the whole span is held back)
+        size_t used = BarcodeEncodeNext(barcode, barcode->pending);
+        if ((int)used >= held)
+        {
+            i += used - held;
+            barcode->numPending = 0;
+        }
+        else
+        {
+            barcode->numPending = held - (int)used;    // (the characters taken from the span are taken again)
+            memmove(barcode->pending, barcode->pending + used, barcode->numPending);
+        }
+    }
+
+    // Directly from the span while there is enough look-ahead
+    while (i + BARCODE_LOOKAHEAD < length)
+    {
+        i += BarcodeEncodeNext(barcode, text + i);
+    }
+
+    // Hold back the remainder
+    while (i < length)
+    {
+        barcode->pending[barcode->numPending++] = text[i++];
+    }
+}
+
+// Finish the barcode: the remaining text, the checksum and stop symbols, and the trailing quiet zone.  Returns the length in bars/bits, or 0 if the text cannot be encoded (or does not fit the buffer).
+size_t BarcodeFinish(barcode_t *barcode)
+{
+    if (barcode->code != BARCODE_CODE_STOP)
+    {
+        // The characters held back are at the end of the text
+        while (barcode->numPending > 0)
+        {
+            char lookahead[BARCODE_LOOKAHEAD + 1] = {0};
+            memcpy(lookahead, barcode->pending, barcode->numPending);
+            size_t used = BarcodeEncodeNext(barcode, lookahead);
+            barcode->numPending -= (int)used;
+            memmove(barcode->pending, barcode->pending + used, barcode->numPending);
+        }
+        BarcodeStop(barcode);
+        BarcodeWriteBits(barcode, 0xffff, barcode->quietZone);
+        BarcodeFlush(barcode);
+    }
+    return barcode->error ? 0 : barcode->offset;
+}
+
+// The symbols so far (including the start, and after finishing the checksum and stop), and optionally how many change the code
+size_t BarcodeSymbols(const barcode_t *barcode, size_t *numCodeChanges)
+{
+    if (numCodeChanges != NULL) *numCodeChanges = barcode->numCodeChanges;
+    return barcode->numSymbols;
+}
+
+// The bytes of the buffer written so far (the bits still held in the accumulator are not yet written)
+size_t BarcodeWritten(const barcode_t *barcode)
+{
+    if (barcode->buffer == NULL) return 0;
+    return (barcode->offset - (size_t)barcode->numBits) >> 3;
+}
+
+// Continue a copy of the state with another buffer, which must start with the bytes written for the original
+void BarcodeResume(barcode_t *barcode, uint8_t *buffer, size_t bufferSize)
+{
+    if (barcode->buffer == NULL || barcode->runs != NULL) return;
+    barcode->buffer = buffer;
+    barcode->bufferSize = bufferSize;
+}
+
+
+// Encodes the whole (NUL-terminated) text and finishes the barcode
+static void BarcodeGenerate(barcode_t *barcode, const char *text, barcode_code_t fixedCode)
+{
+    if (fixedCode == BARCODE_CODE_OPTIMAL)
+    {
+        BarcodeAppendOptimal(barcode, text, strlen(text));
+    }
+    else
+    {
+        BarcodeAppend(barcode, text, strlen(text));
+    }
+    BarcodeFinish(barcode);
+}
+
+// Writes the barcode as a bitmap (0=black, 1=white) using the specified buffer, returns the length in bars/bits. Optionally adds a 10-unit quiet zone either side.
+size_t Barcode(uint8_t *buffer, size_t bufferSize, int quietZone, const char *text, barcode_code_t fixedCode)
+{
+    barcode_t barcode;
+    BarcodeStart(&barcode, buffer, bufferSize, NULL, 0, quietZone, fixedCode);
+    BarcodeGenerate(&barcode, text, fixedCode);
+    return barcode.offset;
+}
+
+// Measures the barcode that would be generated, without writing it, returns the length in bars/bits (0 if the text cannot be encoded), and optionally the number of symbols.
+size_t BarcodeMeasure(int quietZone, const char *text, barcode_code_t fixedCode, size_t *numSymbols)
+{
+    barcode_t barcode;
+    BarcodeStart(&barcode, NULL, 0, NULL, 0, quietZone, fixedCode);
+    BarcodeGenerate(&barcode, text, fixedCode);
+    if (numSymbols != NULL) *numSymbols = barcode.error ? 0 : barcode.numSymbols;
+    return barcode.error ? 0 : barcode.offset;
+}
+
+// Generates the barcode as run widths, alternately space (white) and bar (black), starting with the (possibly zero-width) leading quiet zone, returns the number of runs (0 if the text cannot be encoded or there are too many runs).
+size_t BarcodeRuns(uint16_t *runs, size_t maxRuns, int quietZone, const char *text, barcode_code_t fixedCode)
+{
+    barcode_t barcode;
+    BarcodeStart(&barcode, NULL, 0, runs, maxRuns, quietZone, fixedCode);
+    BarcodeGenerate(&barcode, text, fixedCode);
+    return barcode.error ? 0 : barcode.numRuns;
+}
+
+// Finds the next edge of the bitmap at or after the offset (the first bar/bit that is not of the current color), a whole byte at a time where possible, or the length if there is none
+static size_t BarcodeBitmapEdge(const uint8_t *bitmap, size_t length, size_t i, bool light)
+{
+    while (i < length)
+    {
+        uint8_t other = bitmap[i >> 3] ^ (light ? 0xff : 0x00);     // Set bits are the other color
+#ifdef BARCODE_MSB_FIRST
+        other &= (uint8_t)(0xff >> (i & 7));
+        if (other == 0) { i = (i | 7) + 1; continue; }
+        i &= ~(size_t)7;
+        while (!(other & 0x80)) { other <<= 1; i++; }
+#else
+        other &= (uint8_t)(0xff << (i & 7));
+        if (other == 0) { i = (i | 7) + 1; continue; }
+        i &= ~(size_t)7;
+        while (!(other & 0x01)) { other >>= 1; i++; }
+#endif
+        break;
+    }
+    return (i > length) ? length : i;
+}
+
+// Converts a bitmap (0=black, 1=white) of the specified length in bars/bits to run widths as for BarcodeRuns(), returns the number of runs (0 if there are too many runs).
+size_t BarcodeBitmapRuns(uint16_t *runs, size_t maxRuns, const uint8_t *bitmap, size_t length)
+{
+    size_t numRuns = 0;
+    bool light = true;
+    for (size_t i = 0; i < length; light = !light)
+    {
+        size_t start = i;
+        i = BarcodeBitmapEdge(bitmap, length, i, light);
+        if (numRuns >= maxRuns) return 0;
+        runs[numRuns++] = (uint16_t)(i - start);
+    }
+    return numRuns;
+}
+
+// Sets the masked bits of a byte of a 1 bit per pixel raster
+static inline void BarcodeRasterMerge(uint8_t *p, uint8_t value, uint8_t mask)
+{
+    *p = (uint8_t)((*p & ~mask) | (value & mask));
+}
+
+// Fills a span of pixels of one raster row with white or black, whole bytes at a time
+static void BarcodeRasterFill(uint8_t *row, barcode_raster_format_t format, size_t x, size_t count, bool white)
+{
+    if (count == 0) return;
+    switch (format)
+    {
+        case BARCODE_RASTER_1BPP:
+        {
+            uint8_t value = white ? 0xff : 0x00;
+            uint8_t *p = row + (x >> 3);
+            size_t head = x & 7;
+            if (head + count <= 8)
+            {
+                BarcodeRasterMerge(p, value, (uint8_t)((0xff >> head) & (0xff << (8 - head - count))));
+                break;
+            }
+            if (head) { BarcodeRasterMerge(p++, value, (uint8_t)(0xff >> head)); count -= 8 - head; }
+            memset(p, value, count >> 3);
+            if (count & 7) BarcodeRasterMerge(p + (count >> 3), value, (uint8_t)(0xff << (8 - (count & 7))));
+            break;
+        }
+        case BARCODE_RASTER_GRAY8: memset(row + x, white ? 0xff : 0x00, count); break;
+        case BARCODE_RASTER_RGB565: memset(row + 2 * x, white ? 0xff : 0x00, 2 * count); break;     // Both bytes of black (0x0000) and white (0xffff) are the same
+        case BARCODE_RASTER_RGBA8888:
+        {
+            if (white) { memset(row + 4 * x, 0xff, 4 * count); break; }
+            // Opaque black is not a repeated byte, so two pixels per (unaligned) 64-bit store
+            static const uint8_t black[8] = { 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff };
+            uint8_t *p = row + 4 * x;
+            for (; count >= 2; count -= 2, p += 8) memcpy(p, black, 8);
+            if (count) memcpy(p, black, 4);
+            break;
+        }
+    }
+}
+
+// Copies a span of pixels of a raster row to another row (preserving the neighbouring pixels sharing a byte in 1 bit per pixel)
+static inline void BarcodeRasterCopy(uint8_t *dest, const uint8_t *src, barcode_raster_format_t format, size_t x, size_t count)
+{
+    static const size_t bytesPerPixel[] = { 0, 1, 2, 4 };
+    if (format != BARCODE_RASTER_1BPP) { memcpy(dest + bytesPerPixel[format] * x, src + bytesPerPixel[format] * x, bytesPerPixel[format] * count); return; }
+    size_t head = x & 7;
+    dest += x >> 3; src += x >> 3;
+    if (head + count <= 8)
+    {
+        BarcodeRasterMerge(dest, *src, (uint8_t)((0xff >> head) & (0xff << (8 - head - count))));
+        return;
+    }
+    if (head) { BarcodeRasterMerge(dest++, *src++, (uint8_t)(0xff >> head)); count -= 8 - head; }
+    memcpy(dest, src, count >> 3);
+    if (count & 7) BarcodeRasterMerge(dest + (count >> 3), src[count >> 3], (uint8_t)(0xff << (8 - (count & 7))));
+}
+
+// Rounds a 16.16 fixed-point position to the nearest whole pixel (clamped at zero)
+static inline size_t BarcodeRasterPixel(int64_t position)
+{
+    return (position <= 0) ? 0 : (size_t)((position + 0x8000) >> 16);
+}
+
+// Progress through the bars of a rasterized barcode
+typedef struct
+{
+    const uint8_t *bitmap;
+    size_t length;
+    int64_t step;           // Module width (16.16 fixed-point)
+    int64_t reduction;      // Half the bar-width reduction (16.16 fixed-point)
+    size_t width;           // Width in pixels
+    size_t start;           // Bar/bit index of the next bar
+    size_t position;        // Pixel after the previous bar
+} barcode_raster_t;
+
+// Finds the pixels of the next bar, after the previous bar (the spaces are the pixels in between), returns false if there are no more bars
+static bool BarcodeRasterBar(barcode_raster_t *raster, size_t *left, size_t *right)
+{
+    if (raster->start >= raster->length || raster->position >= raster->width) return false;
+    size_t end = BarcodeBitmapEdge(raster->bitmap, raster->length, raster->start, false);
+    *left = BarcodeRasterPixel((int64_t)raster->start * raster->step + raster->reduction);
+    *right = BarcodeRasterPixel((int64_t)end * raster->step - raster->reduction);
+    if (*left < raster->position) *left = raster->position;
+    if (*left > raster->width) *left = raster->width;
+    if (*right <= *left) *right = *left + 1;    // A bar never disappears entirely
+    if (*right > raster->width) *right = raster->width;
+    raster->position = *right;
+    raster->start = BarcodeBitmapEdge(raster->bitmap, raster->length, end, true);
+    return true;
+}
+
+// Fills whole rows of a ladder (rotated) barcode with one color: only the first row of each color is filled, and the rest are copies of it
+static void BarcodeRasterRows(uint8_t *image, size_t stride, barcode_raster_format_t format, size_t x, size_t first, size_t count, size_t height, bool white, const uint8_t **source)
+{
+    uint8_t *row = image + first * stride;
+    if (count > 0 && *source == NULL)
+    {
+        BarcodeRasterFill(row, format, x, height, white);
+        *source = row;
+        row += stride;
+        count--;
+    }
+    for (; count > 0; count--, row += stride)
+    {
+        BarcodeRasterCopy(row, *source, format, x, height);
+    }
+}
+
+size_t BarcodeRasterize(uint8_t *image, size_t stride, barcode_raster_format_t format, size_t x, size_t y, const uint8_t *bitmap, size_t length, double moduleWidth, double barReduction, size_t height, bool invert)
+{
+    return BarcodeRasterizeRotated(image, stride, format, x, y, bitmap, length, moduleWidth, barReduction, height, invert, BARCODE_ROTATE_0);
+}
+
+size_t BarcodeRasterizeRotated(uint8_t *image, size_t stride, barcode_raster_format_t format, size_t x, size_t y, const uint8_t *bitmap, size_t length, double moduleWidth, double barReduction, size_t height, bool invert, barcode_rotation_t rotation)
+{
+    if (!(moduleWidth > 0) || (unsigned)format > BARCODE_RASTER_RGBA8888 || (unsigned)rotation > BARCODE_ROTATE_270) return 0;
+
+    // Module edges are in 16.16 fixed-point, so fractional widths are rounded the same way for every bar, and each bar is narrowed by half the reduction at either edge
+    barcode_raster_t raster = {0};
+    raster.bitmap = bitmap;
+    raster.length = length;
+    raster.step = (int64_t)(moduleWidth * 65536.0 + 0.5);
+    raster.reduction = (int64_t)(barReduction * 32768.0 + (barReduction < 0 ? -0.5 : 0.5));
+    raster.start = BarcodeBitmapEdge(bitmap, length, 0, true);
+    size_t width = raster.width = BarcodeRasterPixel((int64_t)length * raster.step);
+    if (image == NULL || height == 0 || width == 0) return width;
+    size_t position = 0, left, right;
+
+    // Ladder orientation: each row is a single bar or space, 'height' pixels wide (from the top for 90 degrees, from the bottom for 270 degrees)
+    if (rotation == BARCODE_ROTATE_90 || rotation == BARCODE_ROTATE_270)
+    {
+        const uint8_t *source[2] = { NULL, NULL };  // The first row filled with each color (bar, space)
+        for (bool more = true; more; position = right)
+        {
+            more = BarcodeRasterBar(&raster, &left, &right);
+            if (!more) left = right = width;
+            size_t space = y + ((rotation == BARCODE_ROTATE_90) ? position : width - left);
+            size_t bar = y + ((rotation == BARCODE_ROTATE_90) ? left : width - right);
+            BarcodeRasterRows(image, stride, format, x, space, left - position, height, !invert, &source[1]);
+            BarcodeRasterRows(image, stride, format, x, bar, right - left, height, invert, &source[0]);
+        }
+        return width;
+    }
+
+    // Render the first row a whole run at a time: for each bar, the preceding space then the bar itself (mirrored for 180 degrees)
+    uint8_t *row = image + y * stride;
+#ifdef BARCODE_MSB_FIRST
+    if (format == BARCODE_RASTER_1BPP && raster.step == 0x10000 && raster.reduction == 0 && rotation == BARCODE_ROTATE_0)
+    {
+        // One pixel per module is the bitmap itself, shifted to the offset a byte at a time
+        uint8_t flip = invert ? 0xff : 0x00;
+        size_t shift = x & 7;
+        size_t count = (shift + width + 7) >> 3;
+        uint8_t *p = row + (x >> 3);
+        unsigned int window = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            window = (window << 8) | ((i < BARCODE_SIZE(length)) ? (uint8_t)(bitmap[i] ^ flip) : 0);
+            uint8_t mask = 0xff;
+            if (i == 0) mask &= (uint8_t)(0xff >> shift);
+            if (i == count - 1 && ((shift + width) & 7)) mask &= (uint8_t)(0xff << (8 - ((shift + width) & 7)));
+            BarcodeRasterMerge(p + i, (uint8_t)(window >> shift), mask);
+        }
+        position = width;
+    }
+#endif
+    bool mirror = (rotation == BARCODE_ROTATE_180);
+    for (bool more = true; more && position < width; position = right)
+    {
+        more = BarcodeRasterBar(&raster, &left, &right);
+        if (!more) left = right = width;
+        BarcodeRasterFill(row, format, x + (mirror ? width - left : position), left - position, !invert);
+        BarcodeRasterFill(row, format, x + (mirror ? width - right : left), right - left, invert);
+    }
+
+    // Every row is the same, so copy the first row down
+    for (size_t i = 1; i < height; i++)
+    {
+        BarcodeRasterCopy(row + i * stride, row, format, x, width);
+    }
+    return width;
+}
+
+
+// State while decoding symbols to text
+typedef struct
+{
+    char *text;
+    size_t textSize;
+    size_t length;
+    barcode_code_t code;
+    bool shift;             // Next symbol is from the other of Code A/B
+    int previous;           // Previous symbol (only decoded once it is known not to be the checksum), -1 = none
+    uint32_t checksum;
+    size_t numSymbols;
+    bool error;
+} barcode_decoder_t;
+
+static void BarcodeDecoderInit(barcode_decoder_t *decoder, char *text, size_t textSize)
+{
+    memset(decoder, 0, sizeof(barcode_decoder_t));
+    decoder->text = text;
+    decoder->textSize = textSize;
+    decoder->code = BARCODE_CODE_NONE;
+    decoder->previous = -1;
+}
+
+static void BarcodeDecoderChar(barcode_decoder_t *decoder, char c)
+{
+    if (decoder->length + 1 >= decoder->textSize) { decoder->error = true; return; }
+    decoder->text[decoder->length++] = c;
+}
+
+// Interprets a data symbol in the current code
+static void BarcodeDecoderData(barcode_decoder_t *decoder, int value)
+{
+    barcode_code_t code = decoder->code;
+    if (decoder->shift) code = (code == BARCODE_CODE_A) ? BARCODE_CODE_B : BARCODE_CODE_A;
+    decoder->shift = false;
+
+    if (value >= 103) { decoder->error = true; return; }   // Unexpected start symbol
+    if (code == BARCODE_CODE_C)
+    {
+        if (value < 100)
+        {
+            BarcodeDecoderChar(decoder, (char)('0' + value / 10));
+            BarcodeDecoderChar(decoder, (char)('0' + value % 10));
+        }
+        else if (value == 100) decoder->code = BARCODE_CODE_B;
+        else if (value == 101) decoder->code = BARCODE_CODE_A;
+        // 102 FNC1 ignored
+    }
+    else
+    {
+        if (value < 64 || (value < 96 && code == BARCODE_CODE_B)) BarcodeDecoderChar(decoder, (char)(value + 32));
+        else if (value < 96) BarcodeDecoderChar(decoder, (char)(value - 64));   // Code A control characters
+        else if (value == 98) decoder->shift = true;
+        else if (value == 99) decoder->code = BARCODE_CODE_C;
+        else if (value == 100 && code == BARCODE_CODE_A) decoder->code = BARCODE_CODE_B;
+        else if (value == 101 && code == BARCODE_CODE_B) decoder->code = BARCODE_CODE_A;
+        // 96 FNC3, 97 FNC2, 102 FNC1, and FNC4 ignored
+    }
+}
+
+// Takes the next symbol (the previous one is only interpreted once it is known not to be the checksum)
+static void BarcodeDecoderSymbol(barcode_decoder_t *decoder, int value)
+{
+    if (decoder->numSymbols == 0)
+    {
+        if (value < 103 || value > 105) { decoder->error = true; return; }
+        decoder->code = (value == 103) ? BARCODE_CODE_A : ((value == 104) ? BARCODE_CODE_B : BARCODE_CODE_C);
+        decoder->checksum = (uint32_t)value % 103;
+    }
+    else
+    {
+        if (decoder->previous >= 0)
+        {
+            BarcodeDecoderData(decoder, decoder->previous);
+            decoder->checksum = (decoder->checksum + (uint32_t)(decoder->numSymbols - 1) * (uint32_t)decoder->previous) % 103;
+        }
+        decoder->previous = value;
+    }
+    decoder->numSymbols++;
+}
+
+// After the stop symbol, the previous symbol is the checksum
+static size_t BarcodeDecoderFinish(barcode_decoder_t *decoder, bool *checksumValid)
+{
+    if (decoder->previous < 0 || decoder->shift) decoder->error = true;
+    bool valid = !decoder->error && (uint32_t)decoder->previous == decoder->checksum;
+    if (checksumValid != NULL) *checksumValid = valid;
+    else if (!valid) decoder->error = true;
+    if (decoder->error) return BARCODE_DECODE_ERROR;
+    decoder->text[decoder->length] = '\0';
+    return decoder->length;
+}
+
+// Reads up to 16 bars/bits from the bitmap (first in the most significant bit), bars/bits beyond the length are white
+static uint32_t BarcodeReadBits(const uint8_t *bitmap, size_t length, size_t offset, int count)
+{
+    size_t size = (length + 7) >> 3;
+    size_t index = offset >> 3;
+    uint32_t value = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        value = (value << 8) | ((index + i < size) ? bitmap[index + i] : 0xff);
+    }
+#ifndef BARCODE_MSB_FIRST
+    // Reverse the bit order of each byte
+    value = ((value & 0x555555) << 1) | ((value >> 1) & 0x555555);
+    value = ((value & 0x333333) << 2) | ((value >> 2) & 0x333333);
+    value = ((value & 0x0f0f0f) << 4) | ((value >> 4) & 0x0f0f0f);
+#endif
+    value = (value >> (24 - count - (offset & 7))) & ((1u << count) - 1);
+    if (offset + count > length) value |= (1u << (offset + count - length)) - 1;
+    return value;
+}
+
+// Decodes a bitmap (0=black, 1=white) of the specified length in bars/bits (e.g. from Barcode(), one bar/bit per module), writing the NUL-terminated text.
+size_t BarcodeDecode(char *text, size_t textSize, const uint8_t *bitmap, size_t length, bool *checksumValid)
+{
+    barcode_decoder_t decoder;
+    BarcodeDecoderInit(&decoder, text, textSize);
+
+    // Skip the quiet zone
+    size_t offset = 0;
+    while (offset < length && (offset & 7) != 0 && BARCODE_BIT(bitmap, offset)) offset++;
+    while (offset + 8 <= length && bitmap[offset >> 3] == 0xff) offset += 8;
+    while (offset < length && BARCODE_BIT(bitmap, offset)) offset++;
+
+    for (;;)
+    {
+        if (offset + 11 > length) return BARCODE_DECODE_ERROR;
+        uint32_t pattern = BarcodeReadBits(bitmap, length, offset, 11);
+        int value = ((pattern & 0x401) == 0x001) ? code128Reverse[(pattern >> 1) & 0x1ff] : 0xff;
+        if (value == 0xff) return BARCODE_DECODE_ERROR;
+        if (value == 106)
+        {
+            // The stop symbol ends with a two-bar black
+            if (offset + 13 > length || BarcodeReadBits(bitmap, length, offset + 11, 2) != 0) return BARCODE_DECODE_ERROR;
+            break;
+        }
+        BarcodeDecoderSymbol(&decoder, value);
+        if (decoder.error) return BARCODE_DECODE_ERROR;
+        offset += 11;
+    }
+    return BarcodeDecoderFinish(&decoder, checksumValid);
+}
+
+// Decodes run widths as from BarcodeRuns(), alternately space and bar starting with the quiet zone, writing the NUL-terminated text.  The runs may be at any (integer or not) number of units per bar/bit, as each symbol is scaled by its total width.
+size_t BarcodeDecodeRuns(char *text, size_t textSize, const uint16_t *runs, size_t numRuns, bool *checksumValid)
+{
+    barcode_decoder_t decoder;
+    BarcodeDecoderInit(&decoder, text, textSize);
+
+    // Each symbol is six runs, starting with a bar after the quiet zone
+    for (size_t i = 1; ; i += 6)
+    {
+        if (i + 6 > numRuns) return BARCODE_DECODE_ERROR;
+        uint32_t total = 0;
+        for (int j = 0; j < 6; j++) total += runs[i + j];
+        if (total == 0) return BARCODE_DECODE_ERROR;
+
+        // Scale each run to the nearest number of bars/bits in an 11-bar symbol
+        uint32_t pattern = 0;
+        int modules = 0;
+        for (int j = 0; j < 6; j++)
+        {
+            int width = (int)((22 * (uint32_t)runs[i + j] + total) / (2 * total));
+            if (width < 1 || width > 4) return BARCODE_DECODE_ERROR;
+            pattern = (pattern << width) | ((j & 1) ? ((1u << width) - 1) : 0);
+            modules += width;
+        }
+        if (modules != 11) return BARCODE_DECODE_ERROR;
+        int value = code128Reverse[(pattern >> 1) & 0x1ff];
+        if (value == 0xff) return BARCODE_DECODE_ERROR;
+        if (value == 106)
+        {
+            // The stop symbol ends with a two-bar black
+            if (i + 6 >= numRuns || (22 * (uint32_t)runs[i + 6] + total) / (2 * total) != 2) return BARCODE_DECODE_ERROR;
+            break;
+        }
+        BarcodeDecoderSymbol(&decoder, value);
+        if (decoder.error) return BARCODE_DECODE_ERROR;
+    }
+    return BarcodeDecoderFinish(&decoder, checksumValid);
+}
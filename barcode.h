@@ -1,67 +1,173 @@
-// Barcode - Generates a CODE128 barcode
-// Dan Jackson, 2019
-
-#ifndef BARCODE_H
-#define BARCODE_H
-
-#include <stdbool.h>
-#include <stdint.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-// Global setting to store in to most significant bit first (least significant bit first otherwise)
-#define BARCODE_MSB_FIRST
-
-// (Advanced) Allow using a fixed code type
-typedef enum
-{
-    BARCODE_CODE_NONE,   // Auto / Not started
-    BARCODE_CODE_A,      // ASCII control and upper-case
-    BARCODE_CODE_B,      // ASCII non-control characters
-    BARCODE_CODE_C,      // Double-digit numeric code (Caution: do not use for fixed code type unless you always pass an even number of digits)
-    BARCODE_CODE_STOP,   // (Private) Stopped
-} barcode_code_t;
-
-// The width of the quiet zone (either side of the barcode)
-#define BARCODE_QUIET_NONE 0
-#define BARCODE_QUIET_STANDARD 10
-
-
-// The maximum width (number of bars) required for the EXACT specified number of digits (strictly 0-9), odd numbers are less efficient
-// (Odd: START SYMBOL_PER_TWO_DIGITS CODE_CHANGE LAST_DIGIT CHECKSUM STOP; Even: START SYMBOL_PER_TWO_DIGITS CHECKSUM STOP;)
-#define BARCODE_WIDTH_NUMERIC_EXACT(_digits, _quiet) (2 * (_quiet) + ((3 + ((_digits) / 2) + (((_digits) & 1) ? 2 : 0)) * 11 + 2))
-
-// The maximum width (number of bars) required for the specified number of digits (strictly 0-9)
-#define BARCODE_WIDTH_NUMERIC(_digits, _quiet)       (2 * (_quiet) + ((3 + ((_digits) / 2) + 2) * 11 + 2))
-
-// The maximum width (number of bars) required for the specified amount of (non-control-character) ASCII text
-#define BARCODE_WIDTH_TEXT(_characters, _quiet)      ((2 * (_quiet) + (3 + (_characters)) * 11 + 2))
-
-
-// The maximum number of bytes required for the EXACT specified number of digits (strictly 0-9), odd numbers are less efficient
-#define BARCODE_SIZE_NUMERIC_EXACT(_digits, _quiet)  ((BARCODE_WIDTH_NUMERIC_EXACT((_digits), (_quiet)) + 7) >> 3)
-
-// The maximum number of bytes required for numbers up to the specified number of digits (strictly 0-9)
-#define BARCODE_SIZE_NUMERIC(_digits, _quiet)        ((BARCODE_WIDTH_NUMERIC((_digits), (_quiet)) + 7) >> 3)
-
-// The maximum number of bytes required for the specified amount of (non-control-character) ASCII text
-#define BARCODE_SIZE_TEXT(_digits, _quiet)           ((BARCODE_WIDTH_TEXT((_digits), (_quiet)) + 7) >> 3)
-
-
-// Generates the barcode as a bitmap (0=black, 1=white) using the specified buffer, quiet zone size, and fixed code type (BARCODE_CODE_NONE = Auto), returns the length in bars/bits.
-size_t Barcode(uint8_t *buffer, size_t bufferSize, int quietZone, const char *text, barcode_code_t fixedCode);
-
-// Returns the bar/bit at the specified index in the output bitmap (false=black, true=white)
-#ifdef BARCODE_MSB_FIRST
-    #define BARCODE_BIT(_buffer, _offset) ((*((uint8_t *)(_buffer) + ((_offset) >> 3)) & (1 << (7 - ((_offset) & 7)))) != 0)
-#else
-    #define BARCODE_BIT(_buffer, _offset) ((*((uint8_t *)(_buffer) + ((_offset) >> 3)) & (1 << ((_offset) & 7))) != 0)
-#endif
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+// Barcode - Generates a CODE128 barcode
+// Dan Jackson, 2019
+
+#ifndef BARCODE_H
+#define BARCODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Global setting to store in to most significant bit first (least significant bit first otherwise)
+#define BARCODE_MSB_FIRST
+
+// (Advanced) Allow using a fixed code type
+typedef enum
+{
+    BARCODE_CODE_NONE,   // Auto / Not started
+    BARCODE_CODE_A,      // ASCII control and upper-case
+    BARCODE_CODE_B,      // ASCII non-control characters
+    BARCODE_CODE_C,      // Double-digit numeric code (Caution: do not use for fixed code type unless you always pass an even number of digits)
+    BARCODE_CODE_STOP,   // (Private) Stopped
+    BARCODE_CODE_OPTIMAL, // Auto with minimum width (the fewest symbols, using code changes and SHIFT), rather than the quicker look-ahead choice
+} barcode_code_t;
+
+// The width of the quiet zone (either side of the barcode)
+#define BARCODE_QUIET_NONE 0
+#define BARCODE_QUIET_STANDARD 10
+
+
+// The maximum width (number of bars) required for the EXACT specified number of digits (strictly 0-9), odd numbers are less efficient
+// (Odd: START SYMBOL_PER_TWO_DIGITS CODE_CHANGE LAST_DIGIT CHECKSUM STOP; Even: START SYMBOL_PER_TWO_DIGITS CHECKSUM STOP;)
+#define BARCODE_WIDTH_NUMERIC_EXACT(_digits, _quiet) (2 * (_quiet) + ((3 + ((_digits) / 2) + (((_digits) & 1) ? 2 : 0)) * 11 + 2))
+
+// The maximum width (number of bars) required for the specified number of digits (strictly 0-9)
+#define BARCODE_WIDTH_NUMERIC(_digits, _quiet)       (2 * (_quiet) + ((3 + ((_digits) / 2) + 2) * 11 + 2))
+
+// The maximum width (number of bars) required for the specified amount of (non-control-character) ASCII text
+#define BARCODE_WIDTH_TEXT(_characters, _quiet)      ((2 * (_quiet) + (3 + (_characters)) * 11 + 2))
+
+
+// The maximum number of bytes required for the EXACT specified number of digits (strictly 0-9), odd numbers are less efficient
+#define BARCODE_SIZE_NUMERIC_EXACT(_digits, _quiet)  ((BARCODE_WIDTH_NUMERIC_EXACT((_digits), (_quiet)) + 7) >> 3)
+
+// The maximum number of bytes required for numbers up to the specified number of digits (strictly 0-9)
+#define BARCODE_SIZE_NUMERIC(_digits, _quiet)        ((BARCODE_WIDTH_NUMERIC((_digits), (_quiet)) + 7) >> 3)
+
+// The maximum number of bytes required for the specified amount of (non-control-character) ASCII text
+#define BARCODE_SIZE_TEXT(_digits, _quiet)           ((BARCODE_WIDTH_TEXT((_digits), (_quiet)) + 7) >> 3)
+
+// The number of bytes required for a bitmap of the specified width (number of bars), e.g. as returned by BarcodeMeasure()
+#define BARCODE_SIZE(_width)                         (((_width) + 7) >> 3)
+
+
+// Generates the barcode as a bitmap (0=black, 1=white) using the specified buffer, quiet zone size, and fixed code type (BARCODE_CODE_NONE = Auto), returns the length in bars/bits.
+size_t Barcode(uint8_t *buffer, size_t bufferSize, int quietZone, const char *text, barcode_code_t fixedCode);
+
+// Measures the barcode that would be generated for the same parameters, without writing anything, returns the exact length in bars/bits (0 if the text cannot be encoded), and optionally the number of symbols.
+size_t BarcodeMeasure(int quietZone, const char *text, barcode_code_t fixedCode, size_t *numSymbols);
+
+// The maximum number of run widths for the specified number of symbols (six per symbol, one more for the stop symbol, and the quiet zones)
+#define BARCODE_RUNS(_numSymbols)                    ((_numSymbols) * 6 + 3)
+
+// Generates the barcode as a sequence of run widths, alternately space (white) and bar (black), starting with the leading quiet zone (zero-width if there is none), returns the number of runs (0 if the text cannot be encoded or maxRuns is too small).
+size_t BarcodeRuns(uint16_t *runs, size_t maxRuns, int quietZone, const char *text, barcode_code_t fixedCode);
+
+// Converts a bitmap (0=black, 1=white) of the specified length in bars/bits to run widths as for BarcodeRuns(), returns the number of runs (0 if maxRuns is too small).
+size_t BarcodeBitmapRuns(uint16_t *runs, size_t maxRuns, const uint8_t *bitmap, size_t length);
+
+// Pixel formats for BarcodeRasterize()
+typedef enum
+{
+    BARCODE_RASTER_1BPP,        // 1 bit per pixel, most significant bit first (set=white, clear=black)
+    BARCODE_RASTER_GRAY8,       // 8-bit gray (0xff=white, 0x00=black)
+    BARCODE_RASTER_RGB565,      // 16-bit RGB 5:6:5 (0xffff=white, 0x0000=black)
+    BARCODE_RASTER_RGBA8888,    // 32-bit bytes R, G, B, A (opaque white or black)
+} barcode_raster_format_t;
+
+// Paints a bitmap (0=black, 1=white, e.g. from Barcode()) of the specified length in bars/bits into an existing image of the pixel format and row stride (in bytes), at the pixel offset x, y, for the specified number of rows.
+// The module width in pixels may be fractional (each edge is rounded to the nearest pixel), each bar is narrowed by barReduction pixels (half from either edge, e.g. to compensate for ink spread; negative widens), and invert paints white bars on black.
+// Returns the width in pixels (the image must have room for this at the offset), or 0 if the module width is invalid; if the image is NULL, nothing is painted and only the width is returned.
+size_t BarcodeRasterize(uint8_t *image, size_t stride, barcode_raster_format_t format, size_t x, size_t y, const uint8_t *bitmap, size_t length, double moduleWidth, double barReduction, size_t height, bool invert);
+
+// Rotations (clockwise) for BarcodeRasterizeRotated()
+typedef enum
+{
+    BARCODE_ROTATE_0,
+    BARCODE_ROTATE_90,      // Ladder orientation, the start of the barcode at the top
+    BARCODE_ROTATE_180,
+    BARCODE_ROTATE_270,     // Ladder orientation, the start of the barcode at the bottom
+} barcode_rotation_t;
+
+// As BarcodeRasterize(), but rotated: in ladder orientation (90 or 270 degrees) the painted area is 'height' pixels wide and the returned width tall, and each row is a single bar or space (filled once for each color, then copied).
+size_t BarcodeRasterizeRotated(uint8_t *image, size_t stride, barcode_raster_format_t format, size_t x, size_t y, const uint8_t *bitmap, size_t length, double moduleWidth, double barReduction, size_t height, bool invert, barcode_rotation_t rotation);
+
+// Number of characters of look-ahead held back between spans of incremental encoding
+#define BARCODE_LOOKAHEAD 3
+
+// (Advanced) State of an incremental encoding (the fields are private, use the functions below)
+typedef struct
+{
+    uint8_t *buffer;
+    size_t bufferSize;
+    size_t offset;          // Bars/bits emitted so far (including those still held in the accumulator)
+
+    uint64_t bits;          // Accumulator of bits not yet written to the buffer
+    int numBits;            // Number of bits held in the accumulator
+
+    uint32_t checksum;
+    size_t numSymbols;
+    size_t numCodeChanges;  // CODE A/B/C and SHIFT symbols
+
+    uint16_t *runs;         // Optional output as run widths (alternately space and bar), instead of the bitmap buffer
+    size_t maxRuns;
+    size_t numRuns;
+
+    int quietZone;
+    barcode_code_t fixedCode;
+    char pending[BARCODE_LOOKAHEAD + 1];    // Characters held back until the look-ahead is known
+    int numPending;
+
+    barcode_code_t code;
+    bool error;
+} barcode_t;
+
+// (Advanced) Incremental encoding, for text in several parts or containing NUL: initialize with the bitmap buffer (or NULL to only measure), quiet zone size and fixed code type, then append the text as one or more spans of any length.
+// The look-ahead of the automatic coding continues across spans, so the barcode is the same as for the whole text at once (except that BARCODE_CODE_OPTIMAL requires the whole text, so is coded automatically). NUL is encoded in Code A.
+void BarcodeInit(barcode_t *barcode, uint8_t *buffer, size_t bufferSize, int quietZone, barcode_code_t fixedCode);
+void BarcodeAppend(barcode_t *barcode, const char *text, size_t length);
+
+// The longest text coded optimally (BARCODE_CODE_OPTIMAL), 256 characters by default: the costs of each position are held in a table on the stack (6 bytes per character), and it may be defined higher when building, up to about 10000 (while the 16-bit costs cannot overflow).
+// Longer text is silently coded automatically instead (valid, but not guaranteed to be the fewest symbols).
+#ifndef BARCODE_OPTIMAL_MAX_LENGTH
+#define BARCODE_OPTIMAL_MAX_LENGTH 256
+#endif
+
+// (Advanced) Appends the whole text with the optimal coding (as BARCODE_CODE_OPTIMAL), which must be the only span of the incremental encoding
+void BarcodeAppendOptimal(barcode_t *barcode, const char *text, size_t length);
+
+// Finishes the incremental encoding, returns the length in bars/bits, or 0 if the text cannot be encoded (or does not fit the buffer)
+size_t BarcodeFinish(barcode_t *barcode);
+
+// (Advanced) The number of symbols of the incremental encoding (including the start symbol, and the checksum and stop once finished), and optionally how many of them change the code (CODE A/B/C and SHIFT)
+size_t BarcodeSymbols(const barcode_t *barcode, size_t *numCodeChanges);
+
+// (Advanced) A copy of the state can resume the encoding later (e.g. of values sharing a prefix): the number of bytes of the buffer written so far, which must be saved with the copy and restored to the start of the buffer passed to BarcodeResume()
+size_t BarcodeWritten(const barcode_t *barcode);
+void BarcodeResume(barcode_t *barcode, uint8_t *buffer, size_t bufferSize);
+
+// Returned by the decoders when no valid barcode is found
+#define BARCODE_DECODE_ERROR ((size_t)-1)
+
+// Decodes a bitmap (0=black, 1=white) of the specified length in bars/bits (one bar/bit per module, e.g. from Barcode()), writing the NUL-terminated text (which may also contain NUL from Code A).
+// Returns the length of the text, or BARCODE_DECODE_ERROR if no valid barcode is found (or the text does not fit). If checksumValid is NULL, a checksum mismatch is an error, otherwise the text is returned and checksumValid is set.
+size_t BarcodeDecode(char *text, size_t textSize, const uint8_t *bitmap, size_t length, bool *checksumValid);
+
+// Decodes run widths (alternately space and bar, starting with the quiet zone, e.g. from BarcodeRuns()) at any scale, otherwise as BarcodeDecode().
+size_t BarcodeDecodeRuns(char *text, size_t textSize, const uint16_t *runs, size_t numRuns, bool *checksumValid);
+
+// Returns the bar/bit at the specified index in the output bitmap (false=black, true=white)
+#ifdef BARCODE_MSB_FIRST
+    #define BARCODE_BIT(_buffer, _offset) ((*((uint8_t *)(_buffer) + ((_offset) >> 3)) & (1 << (7 - ((_offset) & 7)))) != 0)
+#else
+    #define BARCODE_BIT(_buffer, _offset) ((*((uint8_t *)(_buffer) + ((_offset) >> 3)) & (1 << ((_offset) & 7))) != 0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
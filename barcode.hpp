@@ -0,0 +1,167 @@
+// Barcode - Generates a CODE128 barcode at compile time (C++14)
+// Dan Jackson, 2019
+
+#ifndef BARCODE_HPP
+#define BARCODE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "barcode.h"
+
+namespace barcode
+{
+    namespace detail
+    {
+        // The same symbol table as the C encoder, usable in constant expressions
+        #include "barcode_code128.h"
+
+        // Encoder state, as barcode_t in barcode.c, writing to a bitmap of the specified size in bytes (0 to only measure)
+        template <std::size_t Size>
+        class Encoder
+        {
+        public:
+            std::uint8_t bitmap[Size > 0 ? Size : 1] {};   // (a plain array, as std::array cannot be modified in a C++14 constant expression)
+            std::size_t offset = 0;
+            bool error = false;
+
+            constexpr Encoder() {}
+
+            // As BarcodeGenerate(): the quiet zone, text (NUL-terminated, or the whole array), checksum and stop symbol, then the quiet zone
+            template <std::size_t Length>
+            constexpr void Generate(int quietZone, const char (&text)[Length], barcode_code_t fixedCode)
+            {
+                WriteBits(0xffff, quietZone);
+                Append(text, Length, fixedCode);
+                Stop();
+                WriteBits(0xffff, quietZone);
+            }
+
+        private:
+            std::uint32_t checksum = 0;
+            std::size_t numSymbols = 0;
+            barcode_code_t code = BARCODE_CODE_NONE;
+
+            static constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+            // Bars/bits of the pattern (most significant first), the pattern repeats if wider than 16 (e.g. quiet zones)
+            constexpr void WriteBits(std::uint16_t pattern, int width)
+            {
+                for (int i = width - 1; i >= 0; i--, offset++)
+                {
+                    if (!((pattern >> (i & 15)) & 1)) continue;
+                    if (Size == 0) continue;
+                    if (offset >= Size * 8) { error = true; continue; }
+#ifdef BARCODE_MSB_FIRST
+                    bitmap[offset >> 3] |= (std::uint8_t)(1 << (7 - (offset & 7)));
+#else
+                    bitmap[offset >> 3] |= (std::uint8_t)(1 << (offset & 7));
+#endif
+                }
+            }
+
+            constexpr void AppendSymbol(int symbol)
+            {
+                if (error || code == BARCODE_CODE_STOP) { error = true; return; }
+                std::uint16_t pattern = code128[symbol];
+                WriteBits(pattern, 10 + ((pattern >> 13) & 0x03));
+                checksum += (numSymbols ? (std::uint32_t)numSymbols : 1) * (std::uint32_t)symbol;
+                checksum %= 103;
+                numSymbols++;
+            }
+
+            constexpr void ChangeCode(barcode_code_t newCode)
+            {
+                if (error || code == newCode) return;
+                if (code == BARCODE_CODE_STOP) { error = true; return; }
+                int symbol = 0;
+                switch (newCode)
+                {
+                    case BARCODE_CODE_A: symbol = (code == BARCODE_CODE_NONE) ? 103 : 101; break;  // START (Code A), or CODE A
+                    case BARCODE_CODE_B: symbol = (code == BARCODE_CODE_NONE) ? 104 : 100; break;  // START (Code B), or CODE B
+                    case BARCODE_CODE_C: symbol = (code == BARCODE_CODE_NONE) ? 105 : 99; break;   // START (Code C), or CODE C
+                    default: error = true; return;
+                }
+                AppendSymbol(symbol);
+                code = newCode;
+            }
+
+            // As the automatic (look-ahead) coding of BarcodeAppend(), or a fixed code A/B/C (BARCODE_CODE_OPTIMAL is not supported at compile time)
+            constexpr void Append(const char *text, std::size_t length, barcode_code_t fixedCode)
+            {
+                if (fixedCode != BARCODE_CODE_NONE && fixedCode != BARCODE_CODE_A && fixedCode != BARCODE_CODE_B && fixedCode != BARCODE_CODE_C) { error = true; return; }
+                std::size_t end = 0;
+                while (end < length && text[end] != '\0') end++;
+                for (std::size_t i = 0; i < end; i++)
+                {
+                    char c0 = text[i];
+                    char c1 = (i + 1 < end) ? text[i + 1] : 0;
+                    char c2 = (i + 2 < end) ? text[i + 2] : 0;
+                    char c3 = (i + 3 < end) ? text[i + 3] : 0;
+
+                    if ((unsigned char)c0 >= 0x80) { error = true; continue; }
+                    barcode_code_t requiredCode = (c0 < 32) ? BARCODE_CODE_A : BARCODE_CODE_B;
+                    if (fixedCode != BARCODE_CODE_NONE) requiredCode = fixedCode;
+
+                    // A fixed code must be able to represent the character (Code C only pairs of digits)
+                    if ((fixedCode == BARCODE_CODE_A && c0 >= 96) || (fixedCode == BARCODE_CODE_B && c0 < 32) || (fixedCode == BARCODE_CODE_C && !(IsDigit(c0) && IsDigit(c1)))) { error = true; continue; }
+
+                    // Code C if there are two numerical digits, but not if already in another code and there isn't a third and fourth.
+                    if (IsDigit(c0) && IsDigit(c1) && !((!IsDigit(c2) || !IsDigit(c3)) && (code == BARCODE_CODE_A || code == BARCODE_CODE_B)) && (fixedCode == BARCODE_CODE_NONE || fixedCode == BARCODE_CODE_C))
+                    {
+                        ChangeCode(BARCODE_CODE_C);
+                        AppendSymbol((c0 - '0') * 10 + (c1 - '0'));     // Code C double digits
+                        i++;
+                    }
+                    else
+                    {
+                        ChangeCode(requiredCode);
+                        AppendSymbol((c0 < 32) ? (c0 + 64) : (c0 - 32));    // Code A control character, otherwise the same in Code A/B
+                    }
+                }
+            }
+
+            constexpr void Stop()
+            {
+                if (code == BARCODE_CODE_NONE) ChangeCode(BARCODE_CODE_B);    // Empty barcodes are barcodes too!
+                AppendSymbol((int)checksum);
+                AppendSymbol(106);
+                code = BARCODE_CODE_STOP;
+            }
+        };
+
+        // Copies the bitmap to the returned array
+        template <std::size_t Size, std::size_t... Index>
+        constexpr std::array<std::uint8_t, Size> ToArray(const std::uint8_t *bitmap, std::index_sequence<Index...>)
+        {
+            return {{ bitmap[Index]... }};
+        }
+    }
+
+    // The length in bars/bits of the barcode for the text, as BarcodeMeasure() (0 if the text cannot be encoded)
+    template <std::size_t Length>
+    constexpr std::size_t Measure(const char (&text)[Length], int quietZone = BARCODE_QUIET_STANDARD, barcode_code_t fixedCode = BARCODE_CODE_NONE)
+    {
+        detail::Encoder<0> encoder;
+        encoder.Generate(quietZone, text, fixedCode);
+        return encoder.error ? 0 : encoder.offset;
+    }
+
+    // The barcode bitmap (0=black, 1=white) for the text, exactly BARCODE_SIZE(Width) bytes, where Width is from Measure() with the same parameters -- see BARCODE_CONSTEXPR()
+    template <std::size_t Width, std::size_t Length>
+    constexpr std::array<std::uint8_t, BARCODE_SIZE(Width)> Generate(const char (&text)[Length], int quietZone = BARCODE_QUIET_STANDARD, barcode_code_t fixedCode = BARCODE_CODE_NONE)
+    {
+        static_assert(Width > 0, "The text cannot be encoded as a barcode");
+        detail::Encoder<BARCODE_SIZE(Width)> encoder;
+        encoder.Generate(quietZone, text, fixedCode);
+        return detail::ToArray<BARCODE_SIZE(Width)>(encoder.bitmap, std::make_index_sequence<BARCODE_SIZE(Width)>());
+    }
+}
+
+// The barcode bitmap for a string literal (and optionally the quiet zone and fixed code), e.g.: static constexpr auto bitmap = BARCODE_CONSTEXPR("ABC123"); the width is BARCODE_CONSTEXPR_WIDTH() with the same parameters.
+#define BARCODE_CONSTEXPR(...) (barcode::Generate<barcode::Measure(__VA_ARGS__)>(__VA_ARGS__))
+#define BARCODE_CONSTEXPR_WIDTH(...) (barcode::Measure(__VA_ARGS__))
+
+#endif
@@ -0,0 +1,224 @@
+// Barcode - Benchmark of the encoder and output renderers
+// Dan Jackson, 2019
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS // This is an example program only
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "barcode.h"
+#include "output.h"
+
+#define BENCH_MAX_WIDTH 2048
+#define BENCH_MAX_TEXT 256
+#define BENCH_RASTER_STRIDE (BENCH_MAX_WIDTH * 4 * 4)   // Largest scale, 32-bit pixels
+#define BENCH_RASTER_HEIGHT 240
+#define BENCH_LADDER_STRIDE (BENCH_RASTER_HEIGHT * 4)   // Rotated: the height is the width
+
+// Representative values to encode
+typedef struct
+{
+    const char *name;
+    const char *value;
+    barcode_code_t fixedCode;
+} bench_corpus_t;
+
+static const bench_corpus_t corpora[] =
+{
+    { "numeric", "12345678901234567890", BARCODE_CODE_NONE },
+    { "short", "AB12CD", BARCODE_CODE_NONE },
+    { "long", "The quick brown fox jumps over the lazy dog, 0123456789 (Code 128) #42!", BARCODE_CODE_NONE },
+    { "control", "\x01" "ABC\tDEF\x1d" "123456\r\n", BARCODE_CODE_NONE },
+    { "fixed_a", "ABC-123/XYZ", BARCODE_CODE_A },
+    { "fixed_b", "Serial no. 42", BARCODE_CODE_B },
+    { "fixed_c", "0123456789012345", BARCODE_CODE_C },
+    { "optimal", "AB1234C567890 mixed 99", BARCODE_CODE_OPTIMAL },
+};
+
+typedef enum
+{
+    BENCH_ENCODE,
+    BENCH_MEASURE,
+    BENCH_RUNS,
+    BENCH_DECODE,
+    BENCH_OUTPUT_INFO,
+    BENCH_OUTPUT_TEXT_WIDE,
+    BENCH_OUTPUT_TEXT_NARROW,
+    BENCH_OUTPUT_IMAGE_BITMAP,
+    BENCH_OUTPUT_PNG,
+    BENCH_OUTPUT_SVG,
+    BENCH_OUTPUT_PDF,
+    BENCH_OUTPUT_SIXEL,
+    BENCH_OUTPUT_TGP,
+    BENCH_OUTPUT_ZPL,
+    BENCH_OUTPUT_EPL,
+    BENCH_RASTER_1BPP,
+    BENCH_RASTER_GRAY8,
+    BENCH_RASTER_RGB565,
+    BENCH_RASTER_RGBA8888,
+    BENCH_LADDER_1BPP,
+    BENCH_LADDER_GRAY8,
+    BENCH_LADDER_RGB565,
+    BENCH_LADDER_RGBA8888,
+    BENCH_OUTPUT_IMAGE_BITMAP_LADDER,
+    BENCH_OUTPUT_PNG_LADDER,
+    BENCH_COUNT,
+} bench_type_t;
+
+static const char *benchNames[BENCH_COUNT] = { "encode", "measure", "runs", "decode", "info", "wide", "narrow", "bmp", "png", "svg", "pdf", "sixel", "tgp", "zpl", "epl", "raster1", "raster8", "raster16", "raster32", "ladder1", "ladder8", "ladder16", "ladder32", "bmp90", "png90" };
+
+typedef struct
+{
+    bench_type_t type;
+    const bench_corpus_t *corpus;
+    int quiet;
+    int scale;
+    int height;
+    uint8_t bitmap[BARCODE_SIZE(BENCH_MAX_WIDTH)];
+    size_t length;
+    uint16_t runs[BENCH_MAX_WIDTH + 1];
+    char text[BENCH_MAX_TEXT];
+    output_t out;
+    uint8_t *image;     // Framebuffer for the rasterizer
+} bench_t;
+
+// Monotonic time in seconds
+static double BenchTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Runs one iteration of the benchmark, returns the number of bytes output
+static size_t BenchRun(bench_t *bench)
+{
+    const bench_corpus_t *corpus = bench->corpus;
+    bench->out.length = 0;
+    switch (bench->type)
+    {
+        case BENCH_ENCODE: return BARCODE_SIZE(Barcode(bench->bitmap, sizeof(bench->bitmap), bench->quiet, corpus->value, corpus->fixedCode));
+        case BENCH_MEASURE: return BARCODE_SIZE(BarcodeMeasure(bench->quiet, corpus->value, corpus->fixedCode, NULL));
+        case BENCH_RUNS: return BarcodeRuns(bench->runs, sizeof(bench->runs) / sizeof(bench->runs[0]), bench->quiet, corpus->value, corpus->fixedCode) * sizeof(bench->runs[0]);
+        case BENCH_DECODE: return BarcodeDecode(bench->text, sizeof(bench->text), bench->bitmap, bench->length, NULL);
+        case BENCH_OUTPUT_INFO: OutputBarcodeInfo(&bench->out, bench->bitmap, bench->length, corpus->value, strlen(corpus->value)); break;
+        case BENCH_OUTPUT_TEXT_WIDE: OutputBarcodeTextWide(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_TEXT_NARROW: OutputBarcodeTextNarrow(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_IMAGE_BITMAP: OutputBarcodeImageBitmap(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_PNG: OutputBarcodePng(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_SVG: OutputBarcodeSvg(&bench->out, bench->bitmap, bench->length, 0.33, bench->height, false); break;
+        case BENCH_OUTPUT_PDF: OutputBarcodePdf(&bench->out, bench->bitmap, bench->length, 0.33, bench->height, false); break;
+        case BENCH_OUTPUT_SIXEL: OutputBarcodeSixel(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_TGP: OutputBarcodeTerminalGraphicsProtocol(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_ZPL: OutputBarcodeZpl(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_OUTPUT_EPL: OutputBarcodeEpl(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false); break;
+        case BENCH_RASTER_1BPP: case BENCH_RASTER_GRAY8: case BENCH_RASTER_RGB565: case BENCH_RASTER_RGBA8888:
+        case BENCH_LADDER_1BPP: case BENCH_LADDER_GRAY8: case BENCH_LADDER_RGB565: case BENCH_LADDER_RGBA8888:
+        {
+            // Painted at an unaligned offset (horizontal, or rotated to the ladder orientation), returns the bytes of the image covered
+            static const size_t bits[] = { 1, 8, 16, 32 };
+            bool ladder = bench->type >= BENCH_LADDER_1BPP;
+            barcode_raster_format_t format = (barcode_raster_format_t)((bench->type - BENCH_RASTER_1BPP) % 4);
+            size_t width = BarcodeRasterizeRotated(bench->image, ladder ? BENCH_LADDER_STRIDE : BENCH_RASTER_STRIDE, format, 3, 0, bench->bitmap, bench->length, bench->scale, 0, bench->height, false, ladder ? BARCODE_ROTATE_90 : BARCODE_ROTATE_0);
+            return ladder ? (bench->height * bits[format] + 7) / 8 * width : (width * bits[format] + 7) / 8 * bench->height;
+        }
+        case BENCH_OUTPUT_IMAGE_BITMAP_LADDER: OutputBarcodeImageBitmapRotated(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false, BARCODE_ROTATE_90); break;
+        case BENCH_OUTPUT_PNG_LADDER: OutputBarcodePngRotated(&bench->out, bench->bitmap, bench->length, bench->scale, bench->height, false, BARCODE_ROTATE_90); break;
+        default: break;
+    }
+    return bench->out.length;
+}
+
+// Times the benchmark for at least the minimum duration, and reports it as a JSON object
+static void BenchReport(bench_t *bench, double minTime, bool first)
+{
+    // The bitmap is generated once for the renderers and decoder
+    bench->length = Barcode(bench->bitmap, sizeof(bench->bitmap), bench->quiet, bench->corpus->value, bench->corpus->fixedCode);
+    OutputInit(&bench->out, NULL);
+    BenchRun(bench);    // Warm up (and grow the output buffer)
+    size_t allocations = bench->out.allocations;
+
+    unsigned long iterations = 0;
+    unsigned long batch = 1;
+    size_t bytes = 0;
+    double start = BenchTime();
+    double elapsed = 0;
+    while (elapsed < minTime)
+    {
+        for (unsigned long i = 0; i < batch; i++)
+        {
+            bytes += BenchRun(bench);
+        }
+        iterations += batch;
+        if (batch < 1048576) batch *= 2;
+        elapsed = BenchTime() - start;
+    }
+    allocations = bench->out.allocations - allocations;
+    OutputFree(&bench->out);
+
+    double ns = elapsed * 1e9 / (double)iterations;
+    double mbps = (double)bytes / elapsed / 1e6;
+    printf("%s    { \"benchmark\": \"%s\", \"corpus\": \"%s\", \"scale\": %d, \"height\": %d, \"iterations\": %lu, \"ns_per_barcode\": %.1f, \"barcodes_per_second\": %.0f, \"bytes_per_barcode\": %.1f, \"mb_per_second\": %.2f, \"allocations_per_barcode\": %.3f }", first ? "" : ",\n", benchNames[bench->type], bench->corpus->name, bench->scale, bench->height, iterations, ns, 1e9 / ns, (double)bytes / (double)iterations, mbps, (double)allocations / (double)iterations);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    double minTime = 0.2;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--time") && i + 1 < argc) { minTime = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) { filter = argv[++i]; }
+        else
+        {
+            fprintf(stderr, "USAGE: barcode-bench [--time 0.2] [--filter benchmark]\n");
+            return -1;
+        }
+    }
+
+    bench_t *bench = (bench_t *)calloc(1, sizeof(bench_t));
+    if (bench != NULL) bench->image = (uint8_t *)malloc(BENCH_RASTER_STRIDE * BENCH_RASTER_HEIGHT);
+    if (bench == NULL || bench->image == NULL) { fprintf(stderr, "ERROR: Out of memory.\n"); return -1; }
+    bool first = true;
+    printf("{\n  \"version\": 1,\n  \"results\": [\n");
+    for (int type = 0; type < BENCH_COUNT; type++)
+    {
+        if (filter != NULL && strcmp(filter, benchNames[type])) continue;
+        bool renderer = type >= BENCH_OUTPUT_INFO;
+        bool image = type == BENCH_OUTPUT_IMAGE_BITMAP || type == BENCH_OUTPUT_PNG || type == BENCH_OUTPUT_SIXEL || type == BENCH_OUTPUT_TGP || type == BENCH_OUTPUT_ZPL || type == BENCH_OUTPUT_EPL || type >= BENCH_RASTER_1BPP;    // (the rasterizer and rotated images)
+        for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++)
+        {
+            // Renderers are timed for a short and a long value, at the demonstration program's default size, and a larger print size for images
+            if (renderer && strcmp(corpora[c].name, "short") && strcmp(corpora[c].name, "long")) continue;
+            for (int size = 0; size < (image ? 2 : 1); size++)
+            {
+                bench->type = (bench_type_t)type;
+                bench->corpus = &corpora[c];
+                bench->quiet = BARCODE_QUIET_STANDARD;
+                bench->scale = size ? 4 : 1;
+                bench->height = image ? (size ? 240 : 30) : 5;
+                BenchReport(bench, minTime, first);
+                first = false;
+            }
+        }
+    }
+    printf("\n  ]\n}\n");
+    free(bench->image);
+    free(bench);
+    return 0;
+}
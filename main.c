@@ -1,384 +1,2380 @@
-// Barcode - Generates a CODE128 barcode
-// Dan Jackson, 2019
-
-#ifdef _WIN32
-#define _CRT_SECURE_NO_WARNINGS // This is an example program only
-#include <windows.h>
-#endif
-#define __STDC_FORMAT_MACROS
-#include <inttypes.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <stdbool.h>
-
-#include "barcode.h"
-
-#define DEFAULT_HEIGHT 5
-
-typedef enum {
-    OUTPUT_INFO,
-    OUTPUT_TEXT_WIDE,
-    OUTPUT_TEXT_NARROW,
-    OUTPUT_IMAGE_BITMAP,
-    OUTPUT_SIXEL,
-    OUTPUT_TGP,
-} output_mode_t;
-
-// Endian-independent short/long read/write
-static void fputshort(uint16_t v, FILE *fp) { fputc((uint8_t)((v >> 0) & 0xff), fp); fputc((uint8_t)((v >> 8) & 0xff), fp); }
-static void fputlong(uint32_t v, FILE *fp) { fputc((uint8_t)((v >> 0) & 0xff), fp); fputc((uint8_t)((v >> 8) & 0xff), fp); fputc((uint8_t)((v >> 16) & 0xff), fp); fputc((uint8_t)((v >> 24) & 0xff), fp); }
-
-static void OutputBarcodeInfo(FILE *fp, uint8_t *bitmap, size_t length, const char *input)
-{
-    size_t size = ((length + 7) >> 3);
-    size_t inputLength = strlen(input);
-    
-    fprintf(fp, "{\n");
-
-    fprintf(fp, "    \"value\": \"");
-    for (size_t i = 0; i < inputLength; i++)
-    {
-        char c = (char)input[i];
-        char out[5] = {0};
-        if (c < 0x20 || c >= 127)
-        {
-            sprintf(out, "\\x%02x", (unsigned int)(c & 0xff));
-        }
-        else if (c == '\\')
-        {
-            sprintf(out, "\\\\");
-        }
-        else if (c == '\"')
-        {
-            sprintf(out, "\\\"");
-        }
-        else
-        {
-            sprintf(out, "%c", c);
-        }
-        fprintf(fp, "%s", out);
-    }
-    fprintf(fp, "\",\n");
-
-    fprintf(fp, "    \"width\": %u,\n", (unsigned int)length);
-
-    fprintf(fp, "    \"bytes\": %u,\n", (unsigned int)size);
-
-    fprintf(fp, "    \"data\": [");
-    for (size_t i = 0; i < size; i++)
-    {
-        fprintf(fp, "%s0x%02x", i > 0 ? ", " : "", bitmap[i]);
-    }
-    fprintf(fp, "]\n");
-
-    fprintf(fp, "}\n");
-}
-
-static void OutputBarcodeTextWide(FILE *fp, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
-{
-    for (int repeat = 0; repeat < height; repeat++)
-    {
-        for (int i = 0; i < scale * length; i++)
-        {
-            bool bit = BARCODE_BIT(bitmap, i / scale) ^ invert;
-            fprintf(fp, "%s", bit ? " " : "█");    // \u{2588} block
-        }
-        fprintf(fp, "\n");
-    }
-}
-
-static void OutputBarcodeTextNarrow(FILE *fp, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
-{
-    for (int repeat = 0; repeat < height; repeat++)
-    {
-        for (int i = 0; i < scale * length; i += 2)
-        {
-            bool bit0 = BARCODE_BIT(bitmap, i / scale);
-            bool bit1 = ((i + 1) / scale) < length ? BARCODE_BIT(bitmap, (i + 1) / scale) : !invert;
-            int value = ((bit0 ? 2 : 0) + (bit1 ? 1 : 0)) ^ (invert ? 0x3 : 0x0);
-            switch (value)
-            {
-                case 0: fprintf(fp, "█"); break; // '\u{2588}' block
-                case 1: fprintf(fp, "▌"); break; // '\u{258C}' left
-                case 2: fprintf(fp, "▐"); break; // '\u{2590}' right
-                case 3: fprintf(fp, " "); break; // '\u{0020}' space
-            }
-        }
-        fprintf(fp, "\n");
-    }
-}
-
-
-static void OutputBarcodeImageBitmap(FILE *fp, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
-{
-    const int BMP_HEADERSIZE = 54;
-    const int BMP_PAL_SIZE = 2 * 4;
-
-    int width = (int)(length * scale);
-    int span = ((width + 31) / 32) * 4;
-    int bufferSize = span * height;
-
-    fputc('B', fp); fputc('M', fp); // bfType
-    fputlong(bufferSize + BMP_HEADERSIZE + BMP_PAL_SIZE, fp); // bfSize
-    fputshort(0, fp);              // bfReserved1
-    fputshort(0, fp);              // bfReserved2
-    fputlong(BMP_HEADERSIZE + BMP_PAL_SIZE, fp); // bfOffBits
-    fputlong(40, fp);              // biSize
-    fputlong(width, fp);           // biWidth
-    fputlong(height, fp);          // biHeight (negative for top-down)
-    fputshort(1, fp);              // biPlanes
-    fputshort(1, fp);              // biBitCount
-    fputlong(0, fp);               // biCompression
-    fputlong(bufferSize, fp);      // biSizeImage
-    fputlong(0, fp);               // biXPelsPerMeter 3780
-    fputlong(0, fp);               // biYPelsPerMeter 3780
-    fputlong(0, fp);               // biClrUsed
-    fputlong(0, fp);               // biClrImportant
-    // Palette Entry 0 - black
-    fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp); 
-    // Palette Entry 1 - white
-    fputc(0xff, fp); fputc(0xff, fp); fputc(0xff, fp); fputc(0x00, fp); 
-    
-    // Bitmap data
-    for (int y = 0; y < height; y++)
-    {
-        for (int h = 0; h < span; h++)
-        {
-            uint8_t v = 0x00;
-            for (int b = 0; b < 8; b++)
-            {
-                int i = (h * 8 + b) / scale;
-                bool bit = (i < length) ? BARCODE_BIT(bitmap, i) ^ invert : 0;
-                v |= bit << (7 - b);
-            }
-            fprintf(fp, "%c", v);
-        }
-    }
-}
-
-
-static void OutputBarcodeSixel(FILE *fp, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
-{
-    const int LINE_HEIGHT = 6;
-    // Enter sixel mode
-    fprintf(fp, "\x1BP7;1q");    // 1:1 ratio, 0 pixels remain at current color
-    // Set color map
-    fprintf(fp, "#0;2;0;0;0");       // Background
-    fprintf(fp, "#1;2;100;100;100");
-    for (int y = 0; y < height; y += LINE_HEIGHT)
-    {
-        const int passes = 2;
-        for (int pass = 0; pass < passes; pass++)
-        {
-            // Start a pass in a specific color
-            fprintf(fp, "#%d", pass);
-            // Line data
-            for (int x = 0; x < scale * length; x += scale)
-            {
-                int value = 0;
-                for (int yy = 0; yy < LINE_HEIGHT; yy++) {
-                    if (y + yy >= height * scale) break;
-                    int bitValue = (BARCODE_BIT(bitmap, x / scale) ^ invert) ? 1 : 0;
-                    int bit = (bitValue == pass) ? 1 : 0;
-                    value |= (bit ? 0x01 : 0x00) << yy;
-                }
-                // Six pixels strip at 'scale' (repeated) width
-                if (scale == 1) {
-                    fprintf(fp, "%c", value + 63);
-                } else if (scale == 2) {
-                    fprintf(fp, "%c%c", value + 63, value + 63);
-                } else if (scale == 3) {
-                    fprintf(fp, "%c%c%c", value + 63, value + 63, value + 63);
-                } else if (scale > 3) {
-                    fprintf(fp, "!%d%c", scale, value + 63);
-                }
-            }
-            // Return to start of the line
-            if (pass + 1 < passes) {
-                fprintf(fp, "$");
-            }
-        }
-        // Next line
-        if (y + LINE_HEIGHT < height * scale) {
-            fprintf(fp, "-");
-        }
-    }
-    // Exit sixel mode
-    fprintf(fp, "\x1B\\");
-    fprintf(fp, "\n");
-}
-
-
-// TGP - Terminal Graphics Protocol
-static void OutputBarcodeTerminalGraphicsProtocol(FILE *fp, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
-{
-    // Image buffer
-    bool alpha = false;
-    size_t imageBufferSize = (size_t)(height * length * scale * (alpha ? 4 : 3));
-    unsigned char *imageBuffer = (unsigned char *)malloc(imageBufferSize);
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < scale * length; x++)
-        {
-            int bitValue = (BARCODE_BIT(bitmap, x / scale) ^ invert) ? 1 : 0;
-            int ofs = (y * length * scale + x) * (alpha ? 4 : 3);
-            imageBuffer[ofs + 0] = bitValue ? 0xff : 0x00; // R
-            imageBuffer[ofs + 1] = bitValue ? 0xff : 0x00; // G
-            imageBuffer[ofs + 2] = bitValue ? 0xff : 0x00; // B
-        }
-    }
-
-    // Convert to Base64
-    size_t base64Size = ((imageBufferSize + 2) / 3) * 4;
-    char *base64Buffer = (char *)malloc(base64Size + 1);
-    // Manually encode to Base64
-    const char *base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    for (size_t i = 0; i < imageBufferSize; i += 3)
-    {
-        uint32_t value = (imageBuffer[i] << 16) | (i + 1 < imageBufferSize ? (imageBuffer[i + 1] << 8) : 0) | (i + 2 < imageBufferSize ? imageBuffer[i + 2] : 0);
-        size_t ofs = (i / 3) * 4;
-        base64Buffer[ofs++] = base64Chars[(value >> 18) & 0x3f];
-        base64Buffer[ofs++] = base64Chars[(value >> 12) & 0x3f];
-        base64Buffer[ofs++] = (i + 1 < imageBufferSize) ? base64Chars[(value >> 6) & 0x3f] : '=';
-        base64Buffer[ofs++] = (i + 2 < imageBufferSize) ? base64Chars[value & 0x3f] : '=';
-    }
-
-    // Chunked output
-    int MAX_CHUNK_SIZE = 4096;
-    char initialControls[256];
-    for (size_t i = 0; i < base64Size; i += MAX_CHUNK_SIZE) {
-        int chunkSize = (i + MAX_CHUNK_SIZE < base64Size) ? MAX_CHUNK_SIZE : (base64Size - i);
-        char *chunk = base64Buffer + i;
-        if (i == 0) {
-            // action transmit and display (a=T), direct transfer (t=d), uncompressed (o=), 3/4 bytes per pixel (f=24/32 bits per pixel), no responses at all (q=2)
-            sprintf(initialControls, "a=T,f=%d,s=%d,v=%d,t=d,q=2,", alpha ? 32 : 24, (int)(length * scale), (int)(height));
-        } else {
-            initialControls[0] = '\0';
-        }
-        int nonTerminal = (i + MAX_CHUNK_SIZE < base64Size) ? 1 : 0;
-        fprintf(fp, "\x1B_G%sm=%d;%.*s\x1B\\", initialControls, nonTerminal, (int)chunkSize, chunk);
-    }
-    fprintf(fp, "\n");
-
-    // Clear up buffers
-    free(base64Buffer);
-    free(imageBuffer);
-
-    return;
-}
-
-
-int main(int argc, char *argv[])
-{
-    FILE *ofp = stdout;
-    const char *value = NULL;
-    bool help = false;
-    bool invert = false;
-    int quiet = BARCODE_QUIET_STANDARD;
-    output_mode_t outputMode = OUTPUT_TEXT_NARROW;
-    int scale = -1;
-    int height = -1;
-    bool address = false;
-    barcode_code_t fixedCode = BARCODE_CODE_NONE;
-
-    for (int i = 1; i < argc; i++)
-    {
-        if (!strcmp(argv[i], "--help")) { help = true; }
-        else if (!strcmp(argv[i], "--height")) { height = atoi(argv[++i]); }
-        else if (!strcmp(argv[i], "--scale")) { scale = atoi(argv[++i]); }
-        else if (!strcmp(argv[i], "--quiet")) { quiet = atoi(argv[++i]); }
-        else if (!strcmp(argv[i], "--invert")) { invert = !invert; }
-        else if (!strcmp(argv[i], "--file"))
-        {
-            ofp = fopen(argv[++i], "wb");
-            if (ofp == NULL) { fprintf(stderr, "ERROR: Unable to open output filename: %s\n", argv[i]); return -1; }
-        }
-        else if (!strcmp(argv[i], "--output:info")) { outputMode = OUTPUT_INFO; }
-        else if (!strcmp(argv[i], "--output:wide")) { outputMode = OUTPUT_TEXT_WIDE; }
-        else if (!strcmp(argv[i], "--output:narrow")) { outputMode = OUTPUT_TEXT_NARROW; }
-        else if (!strcmp(argv[i], "--output:bmp")) { outputMode = OUTPUT_IMAGE_BITMAP; }
-        else if (!strcmp(argv[i], "--output:sixel")) { outputMode = OUTPUT_SIXEL; }
-        else if (!strcmp(argv[i], "--output:tgp")) { outputMode = OUTPUT_TGP; }
-        else if (!strcmp(argv[i], "--code:auto")) { fixedCode = BARCODE_CODE_NONE; }
-        else if (!strcmp(argv[i], "--code:a")) { fixedCode = BARCODE_CODE_A; }
-        else if (!strcmp(argv[i], "--code:b")) { fixedCode = BARCODE_CODE_B; }
-        else if (!strcmp(argv[i], "--code:c")) { fixedCode = BARCODE_CODE_C; }
-        else if (!strcmp(argv[i], "--address")) { address = true; }
-        else if (argv[i][0] == '-')
-        {
-            fprintf(stderr, "ERROR: Unrecognized parameter: %s\n", argv[i]); 
-            help = true;
-            break;
-        }
-        else if (value == NULL)
-        {
-            value = argv[i];
-        }
-        else
-        {
-            fprintf(stderr, "ERROR: Unrecognized positional parameter: %s\n", argv[i]); 
-            help = true;
-            break;
-        }
-    }
-
-    if (value == NULL)
-    {
-        fprintf(stderr, "ERROR: Value not specified.\n"); 
-        help = true;
-    }
-
-    if (help)
-    {
-        fprintf(stderr, "USAGE: barcode [--height 5] [--scale 1] [--quiet 10] [--invert] [--output:<wide|narrow|bmp|sixel|tgp>] [--file filename] <value>\n"); 
-        return -1;
-    }
-
-    if (address) 
-    {
-        // Special decimal conversion for 6-byte Bluetooth hex addresses given in the format: "01:23:45:67:89:AB", ignoring top two bits (signify private address), output is 128 pixel width.
-        if (strlen(value) != 17 || value[2] != ':' || value[5] != ':' || value[8] != ':' || value[11] != ':' || value[14] != ':')  { fprintf(stderr, "ERROR: Address format error: %s\n", value); return -1; }
-        static char buffer[14 + 1];
-        uint64_t address = ((uint64_t)strtoul(value + 0, NULL, 16) << 40) | ((uint64_t)strtoul(value + 3, NULL, 16) << 32) | ((uint64_t)strtoul(value + 6, NULL, 16) << 24) | ((uint64_t)strtoul(value + 9, NULL, 16) << 16) | ((uint64_t)strtoul(value + 12, NULL, 16) << 8) | ((uint64_t)strtoul(value + 15, NULL, 16));
-        address &= (uint64_t)0x003fffffffffffull;   // Mask off top two bits (46-bit number)
-        sprintf(buffer, "%014"PRIu64"", address);   // Max value is 70368744177663 (14 digits)
-        printf("Address: %02x:%02x:%02x:%02x:%02x:%02x\n", (int)((address >> (5*8)) & 0xff),  (int)((address >> (4*8)) & 0xff), (int)((address >> (3*8)) & 0xff), (int)((address >> (2*8)) & 0xff), (int)((address >> (1*8)) & 0xff), (int)((address) & 0xff));
-        printf("Decimal: %s\n", buffer);
-        value = buffer;
-        quiet = 8;
-    }
-
-    // Defaults
-    if (height < 0)
-    {
-        height = (outputMode == OUTPUT_SIXEL || outputMode == OUTPUT_TGP || outputMode == OUTPUT_IMAGE_BITMAP) ? 30 : DEFAULT_HEIGHT;
-    }
-    if (scale < 0)
-    {
-        scale = (outputMode == OUTPUT_SIXEL || outputMode == OUTPUT_TGP || outputMode == OUTPUT_IMAGE_BITMAP) ? 1 : 1;
-    }
-
-    // Generates the barcode as a bitmap (0=black, 1=white) using the specified buffer, returns the length in bars/bits. Optionally adds a 10-unit quiet zone either side.
-    uint8_t bitmap[BARCODE_SIZE_TEXT(14, BARCODE_QUIET_STANDARD)] = {0};
-    size_t length = Barcode(bitmap, sizeof(bitmap), quiet, value, fixedCode);
-    //printf("Length = %d\n", (int)length);
-
-#ifdef _WIN32
-    if (outputMode == OUTPUT_TEXT_WIDE || outputMode == OUTPUT_TEXT_NARROW) SetConsoleOutputCP(CP_UTF8);
-#endif
-
-    switch (outputMode)
-    {
-        case OUTPUT_INFO: OutputBarcodeInfo(ofp, bitmap, length, value); break;
-        case OUTPUT_TEXT_WIDE: OutputBarcodeTextWide(ofp, bitmap, length, scale, height, invert); break;
-        case OUTPUT_TEXT_NARROW: OutputBarcodeTextNarrow(ofp, bitmap, length, scale, height, invert); break;
-        case OUTPUT_IMAGE_BITMAP: OutputBarcodeImageBitmap(ofp, bitmap, length, scale, height, invert); break;
-        case OUTPUT_SIXEL: OutputBarcodeSixel(ofp, bitmap, length, scale, height, invert); break;
-        case OUTPUT_TGP: OutputBarcodeTerminalGraphicsProtocol(ofp, bitmap, length, scale, height, invert); break;
-        default: fprintf(ofp, "<error>"); break;
-    }
-
-    if (ofp != stdout) fclose(ofp);
-    return 0;
-}
+// Barcode - Generates a CODE128 barcode
+// Dan Jackson, 2019
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS // This is an example program only
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifndef NO_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#endif
+#include <stddef.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "barcode.h"
+#include "output.h"
+
+#define DEFAULT_HEIGHT 5
+#define DEFAULT_MODULE_SIZE 0.33   // millimeters
+
+typedef enum {
+    OUTPUT_INFO,
+    OUTPUT_TEXT_WIDE,
+    OUTPUT_TEXT_NARROW,
+    OUTPUT_IMAGE_BITMAP,
+    OUTPUT_PNG,
+    OUTPUT_SVG,
+    OUTPUT_PDF,
+    OUTPUT_SIXEL,
+    OUTPUT_TGP,
+    OUTPUT_ZPL,
+    OUTPUT_EPL,
+} output_mode_t;
+
+// Reads delimited records (newline or NUL) from a file: memory-mapped where possible (not on Windows, or if built with NO_MMAP), otherwise in large blocks.  Each record (or a column of it) is returned as a span in place, without a per-record allocation or copy.
+typedef struct
+{
+    FILE *fp;
+    char *buffer;
+    size_t capacity;
+    size_t start;       // Offset of the next unread record
+    size_t end;         // Offset of the end of the valid data
+    char delimiter;
+    bool eof;
+    bool mapped;        // The buffer is the whole file, memory-mapped (read-only)
+    char separator;     // Column separator (e.g. ',' or '\t'), or '\0' for whole records
+    bool quoted;        // Fields may be quoted (CSV): delimiters and separators within quotes are part of the field, and "" is a quote
+    int column;         // Column returned (0 = first)
+    char *field;        // Unquoted copy of a field containing escaped quotes (reused)
+    size_t fieldCapacity;
+} record_reader_t;
+
+#define RECORD_READER_BLOCK (64 * 1024)
+
+static bool RecordReaderInit(record_reader_t *reader, FILE *fp, char delimiter)
+{
+    memset(reader, 0, sizeof(record_reader_t));
+    reader->fp = fp;
+    reader->delimiter = delimiter;
+#if !defined(_WIN32) && !defined(NO_MMAP)
+    // Map a regular file (the pages are read on demand and can be discarded, rather than the file being read into the heap)
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (uint64_t)st.st_size <= (uint64_t)(SIZE_MAX / 2))
+    {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (map != MAP_FAILED)
+        {
+            posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            reader->buffer = (char *)map;
+            reader->capacity = reader->end = (size_t)st.st_size;
+            reader->mapped = true;
+            reader->eof = true;
+            return true;
+        }
+    }
+#endif
+    reader->capacity = RECORD_READER_BLOCK;
+    reader->buffer = (char *)malloc(reader->capacity);
+    return reader->buffer != NULL;
+}
+
+// Finds the delimiter at the end of the record (not within quotes, if quoted), or NULL if not yet read
+static const char *RecordReaderDelimiter(const record_reader_t *reader, const char *begin, const char *limit)
+{
+    const char *p = (const char *)memchr(begin, reader->delimiter, (size_t)(limit - begin));
+    if (!reader->quoted) return p;
+    bool inQuotes = false;
+    const char *q = begin;
+    while (p != NULL)
+    {
+        const char *quote;
+        while ((quote = (const char *)memchr(q, '"', (size_t)(p - q))) != NULL) { inQuotes = !inQuotes; q = quote + 1; }
+        if (!inQuotes) return p;
+        q = p + 1;
+        p = (const char *)memchr(q, reader->delimiter, (size_t)(limit - q));
+    }
+    return NULL;
+}
+
+// Selects the reader's column of the record (empty if there are fewer columns), without its quotes (in place, unless it contains escaped quotes)
+static bool RecordReaderColumn(record_reader_t *reader, const char **record, size_t *length)
+{
+    const char *p = *record;
+    const char *end = p + *length;
+    for (int column = 0; ; column++)
+    {
+        const char *fieldStart = p;
+        const char *fieldEnd;
+        bool escaped = false;
+        if (reader->quoted && p < end && *p == '"')
+        {
+            // Quoted field, ending at an unpaired quote (anything after it, up to the separator, is ignored)
+            const char *q = p + 1;
+            while ((q = (const char *)memchr(q, '"', (size_t)(end - q))) != NULL && q + 1 < end && q[1] == '"') { escaped = true; q += 2; }
+            fieldStart = p + 1;
+            fieldEnd = (q != NULL) ? q : end;
+            p = (const char *)memchr(fieldEnd, reader->separator, (size_t)(end - fieldEnd));
+        }
+        else
+        {
+            p = (const char *)memchr(p, reader->separator, (size_t)(end - p));
+            fieldEnd = (p != NULL) ? p : end;
+        }
+        if (column == reader->column)
+        {
+            *record = fieldStart;
+            *length = (size_t)(fieldEnd - fieldStart);
+            if (!escaped) return true;
+            if (*length > reader->fieldCapacity)
+            {
+                char *field = (char *)realloc(reader->field, *length);
+                if (field == NULL) { fprintf(stderr, "ERROR: Out of memory reading field.\n"); return false; }
+                reader->field = field;
+                reader->fieldCapacity = *length;
+            }
+            size_t o = 0;
+            for (const char *c = fieldStart; c < fieldEnd; c++)
+            {
+                reader->field[o++] = *c;
+                if (*c == '"') c++;
+            }
+            *record = reader->field;
+            *length = o;
+            return true;
+        }
+        if (p == NULL) { *record = end; *length = 0; return true; }
+        p++;
+    }
+}
+
+// Returns the next record (or its column, if selected) as a span, valid until the next call, or false at the end of the input
+static bool RecordReaderNext(record_reader_t *reader, const char **record, size_t *length)
+{
+    for (;;)
+    {
+        const char *p = RecordReaderDelimiter(reader, reader->buffer + reader->start, reader->buffer + reader->end);
+        if (p == NULL && reader->eof && reader->start < reader->end)
+        {
+            p = reader->buffer + reader->end;   // Final record without a trailing delimiter
+        }
+        if (p != NULL)
+        {
+            *record = reader->buffer + reader->start;
+            *length = (size_t)(p - *record);
+            reader->start = (size_t)(p - reader->buffer) + (p < reader->buffer + reader->end ? 1 : 0);
+            if (reader->delimiter == '\n' && *length > 0 && (*record)[*length - 1] == '\r') (*length)--;
+            if (reader->separator != '\0') return RecordReaderColumn(reader, record, length);
+            return true;
+        }
+        if (reader->eof) return false;
+
+        // Move the partial record to the start of the buffer, growing it if the record fills it
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+        if (reader->capacity - reader->end < RECORD_READER_BLOCK / 2)
+        {
+            char *buffer = (char *)realloc(reader->buffer, reader->capacity * 2);
+            if (buffer == NULL) { fprintf(stderr, "ERROR: Out of memory reading record.\n"); return false; }
+            reader->buffer = buffer;
+            reader->capacity *= 2;
+        }
+        size_t count = fread(reader->buffer + reader->end, 1, reader->capacity - reader->end, reader->fp);
+        if (count == 0) reader->eof = true;
+        reader->end += count;
+    }
+}
+
+static void RecordReaderClose(record_reader_t *reader)
+{
+#if !defined(_WIN32) && !defined(NO_MMAP)
+    if (reader->mapped) munmap(reader->buffer, reader->capacity);
+    else
+#endif
+    free(reader->buffer);
+    free(reader->field);
+    reader->buffer = NULL;
+    reader->field = NULL;
+}
+
+// Expands an output filename (or sequence value) template: %n = record number (optionally zero-padded, e.g. %06n), %v = value (unsafe characters replaced), %% = percent
+static bool ExpandTemplate(char *filename, size_t filenameSize, const char *template, unsigned long recordNumber, const char *value, size_t valueLength)
+{
+    size_t o = 0;
+    for (const char *t = template; *t != '\0'; t++)
+    {
+        char part[32];
+        const char *insert = part;
+        size_t insertLength = 1;
+        part[0] = *t; part[1] = '\0';
+        if (*t == '%')
+        {
+            int width = 0;
+            while (t[1] >= '0' && t[1] <= '9') width = width * 10 + (*++t - '0');
+            if (t[1] == 'n') { insertLength = (size_t)sprintf(part, "%0*lu", width > 20 ? 20 : width, recordNumber); t++; }
+            else if (t[1] == 'v') { insert = value; insertLength = valueLength; t++; }
+            else if (t[1] == '%') { t++; }
+            else return false;
+        }
+        for (size_t i = 0; i < insertLength; i++)
+        {
+            char c = insert[i];
+            if (o + 1 >= filenameSize) return false;
+            bool unsafe = (insert == value) && (c < 0x20 || c >= 0x7f || strchr("/\\:*?\"<>|", c) != NULL);
+            filename[o++] = unsafe ? '_' : c;
+        }
+    }
+    filename[o] = '\0';
+    return true;
+}
+
+// Options shared by every barcode generated
+typedef struct
+{
+    output_mode_t outputMode;
+    int quiet;
+    int scale;
+    int height;
+    double moduleSize;  // Vector output module size (millimeters)
+    bool invert;
+    barcode_rotation_t rotation;    // Clockwise (ladder orientation at 90 or 270 degrees is only for BMP and PNG)
+    barcode_code_t fixedCode;
+    bool verify;
+    int prefixCache;    // Entries of each encoder's prefix state cache (0 to disable)
+    bool resume;        // Keep encoder states to resume values sharing a prefix with the previous or a cached one (--sequence or --prefix-cache)
+    bool stats;         // Collect statistics (unless built with NO_STATS)
+    double statsInterval;   // Seconds between reports of the statistics (0 for only at the end)
+} options_t;
+
+// Defaults for the output mode, for the options not specified
+static void OptionsDefaults(options_t *options)
+{
+    if (options->height < 0)
+    {
+        options->height = (options->outputMode == OUTPUT_SIXEL || options->outputMode == OUTPUT_TGP || options->outputMode == OUTPUT_ZPL || options->outputMode == OUTPUT_EPL || options->outputMode == OUTPUT_IMAGE_BITMAP || options->outputMode == OUTPUT_PNG || options->outputMode == OUTPUT_SVG || options->outputMode == OUTPUT_PDF) ? 30 : DEFAULT_HEIGHT;
+    }
+    if (options->scale < 0)
+    {
+        options->scale = (options->outputMode == OUTPUT_SIXEL || options->outputMode == OUTPUT_TGP || options->outputMode == OUTPUT_IMAGE_BITMAP || options->outputMode == OUTPUT_PNG) ? 1 : 1;
+    }
+}
+
+#define PREFIX_CACHE_MAX_LENGTH 64    // Longest prefix cached (characters)
+
+// A cached encoder state after a prefix: the state holds any look-ahead characters not yet coded, so the coding at the prefix boundary is decided exactly as when encoding the whole value
+typedef struct
+{
+    uint32_t hash;
+    int next;               // Next entry in the hash bucket
+    int older;              // Least-recently used list
+    int newer;
+    size_t length;
+    char key[PREFIX_CACHE_MAX_LENGTH];
+    barcode_t state;
+    size_t written;         // Bitmap bytes written for the prefix (stored at the entry's slot of the cache's bytes)
+} prefix_entry_t;
+
+// A bounded (least-recently used) cache of encoder states after common prefixes (e.g. a site code or company prefix), for values that do not simply follow on from the previous one
+typedef struct
+{
+    prefix_entry_t *entries;
+    int capacity;
+    int count;
+    int *buckets;
+    int numBuckets;         // (power of two)
+    int newest;
+    int oldest;
+    uint8_t *bytes;
+    size_t bytesPerEntry;
+    unsigned long hits;
+    unsigned long misses;
+} prefix_cache_t;
+
+static bool PrefixCacheInit(prefix_cache_t *cache, int capacity, int quietZone)
+{
+    memset(cache, 0, sizeof(prefix_cache_t));
+    cache->capacity = capacity;
+    cache->numBuckets = 1;
+    while (cache->numBuckets < 2 * capacity) cache->numBuckets *= 2;
+    cache->bytesPerEntry = BARCODE_SIZE((size_t)(quietZone > 0 ? quietZone : 0) + (2 * PREFIX_CACHE_MAX_LENGTH + 1) * 11);
+    cache->entries = (prefix_entry_t *)malloc(capacity * sizeof(prefix_entry_t));
+    cache->buckets = (int *)malloc(cache->numBuckets * sizeof(int));
+    cache->bytes = (uint8_t *)malloc(capacity * cache->bytesPerEntry);
+    if (cache->entries == NULL || cache->buckets == NULL || cache->bytes == NULL) return false;
+    for (int i = 0; i < cache->numBuckets; i++) cache->buckets[i] = -1;
+    cache->newest = cache->oldest = -1;
+    return true;
+}
+
+static void PrefixCacheFree(prefix_cache_t *cache)
+{
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache->bytes);
+    memset(cache, 0, sizeof(prefix_cache_t));
+}
+
+// Removes every entry (e.g. when the quiet zone or code changes)
+static void PrefixCacheClear(prefix_cache_t *cache)
+{
+    for (int i = 0; i < cache->numBuckets; i++) cache->buckets[i] = -1;
+    cache->count = 0;
+    cache->newest = cache->oldest = -1;
+}
+
+// FNV-1a hash of each prefix of the text: hashes[n] is of the first n characters
+static void PrefixHashes(uint32_t *hashes, const char *text, size_t length)
+{
+    hashes[0] = 2166136261u;
+    for (size_t i = 0; i < length; i++) hashes[i + 1] = (hashes[i] ^ (uint8_t)text[i]) * 16777619u;
+}
+
+static void PrefixCacheUnlink(prefix_cache_t *cache, int index)
+{
+    prefix_entry_t *entry = &cache->entries[index];
+    if (entry->older >= 0) cache->entries[entry->older].newer = entry->newer; else cache->oldest = entry->newer;
+    if (entry->newer >= 0) cache->entries[entry->newer].older = entry->older; else cache->newest = entry->older;
+}
+
+static void PrefixCacheLinkNewest(prefix_cache_t *cache, int index)
+{
+    prefix_entry_t *entry = &cache->entries[index];
+    entry->older = cache->newest;
+    entry->newer = -1;
+    if (cache->newest >= 0) cache->entries[cache->newest].newer = index; else cache->oldest = index;
+    cache->newest = index;
+}
+
+// Finds the entry for the prefix (marking it the most recently used), or -1 if not cached
+static int PrefixCacheFind(prefix_cache_t *cache, uint32_t hash, const char *prefix, size_t length)
+{
+    for (int index = cache->buckets[hash & (cache->numBuckets - 1)]; index >= 0; index = cache->entries[index].next)
+    {
+        prefix_entry_t *entry = &cache->entries[index];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->key, prefix, length) == 0)
+        {
+            if (cache->newest != index) { PrefixCacheUnlink(cache, index); PrefixCacheLinkNewest(cache, index); }
+            return index;
+        }
+    }
+    return -1;
+}
+
+// Caches the encoder state after the prefix, replacing the least-recently used entry when full
+static void PrefixCacheInsert(prefix_cache_t *cache, uint32_t hash, const char *prefix, size_t length, const barcode_t *state, const uint8_t *bitmap)
+{
+    size_t written = BarcodeWritten(state);
+    if (length == 0 || length > PREFIX_CACHE_MAX_LENGTH || written > cache->bytesPerEntry) return;
+    if (PrefixCacheFind(cache, hash, prefix, length) >= 0) return;
+    int index;
+    if (cache->count < cache->capacity)
+    {
+        index = cache->count++;
+    }
+    else
+    {
+        index = cache->oldest;
+        PrefixCacheUnlink(cache, index);
+        int *link = &cache->buckets[cache->entries[index].hash & (cache->numBuckets - 1)];
+        while (*link != index) link = &cache->entries[*link].next;
+        *link = cache->entries[index].next;
+    }
+    prefix_entry_t *entry = &cache->entries[index];
+    entry->hash = hash;
+    entry->length = length;
+    memcpy(entry->key, prefix, length);
+    entry->state = *state;
+    entry->written = written;
+    memcpy(cache->bytes + (size_t)index * cache->bytesPerEntry, bitmap, written);
+    int *bucket = &cache->buckets[hash & (cache->numBuckets - 1)];
+    entry->next = *bucket;
+    *bucket = index;
+    PrefixCacheLinkNewest(cache, index);
+}
+
+#ifndef NO_STATS
+// Statistics of the barcodes generated (--stats), unless built with NO_STATS
+#define STATS(_code) _code
+#define STATS_SUBBUCKETS 8                              // Latency histogram buckets per power of two (nanoseconds)
+#define STATS_BUCKETS ((48 - 2) * STATS_SUBBUCKETS)
+
+typedef struct
+{
+    uint64_t barcodes;
+    uint64_t encodeErrors;      // The encoder's error: a character that cannot be encoded (with the code), or the buffer too small
+    uint64_t verifyErrors;
+    uint64_t symbols;
+    uint64_t codeChanges;       // CODE A/B/C and SHIFT symbols
+    uint64_t bytesRendered;
+    uint64_t bytesWritten;
+    double encodeTime;          // Seconds in each stage
+    double verifyTime;
+    double renderTime;
+    double writeTime;
+    uint64_t latency[STATS_BUCKETS];    // Histogram of the time to encode, verify and render each barcode
+} stats_t;
+
+static stats_t statsTotal;      // Statistics of the freed encoders and closed outputs
+static double statsStart;
+static double statsNext;        // Time of the next periodic report
+
+static void StatsMerge(stats_t *stats, const stats_t *add)
+{
+    stats->barcodes += add->barcodes;
+    stats->encodeErrors += add->encodeErrors;
+    stats->verifyErrors += add->verifyErrors;
+    stats->symbols += add->symbols;
+    stats->codeChanges += add->codeChanges;
+    stats->bytesRendered += add->bytesRendered;
+    stats->bytesWritten += add->bytesWritten;
+    stats->encodeTime += add->encodeTime;
+    stats->verifyTime += add->verifyTime;
+    stats->renderTime += add->renderTime;
+    stats->writeTime += add->writeTime;
+    for (int i = 0; i < STATS_BUCKETS; i++) stats->latency[i] += add->latency[i];
+}
+
+// Adds the writes to a file
+static void StatsOutput(stats_t *stats, const output_t *out)
+{
+    stats->bytesWritten += out->written;
+    stats->writeTime += out->writeTime;
+}
+
+// Log-linear histogram bucket of a time in nanoseconds
+static int StatsBucket(uint64_t ns)
+{
+    if (ns < STATS_SUBBUCKETS) return (int)ns;
+    int exponent = 3;
+    while ((ns >> (exponent + 1)) != 0 && exponent < 47) exponent++;
+    int bucket = (exponent - 2) * STATS_SUBBUCKETS + (int)((ns >> (exponent - 3)) & (STATS_SUBBUCKETS - 1));
+    return (bucket < STATS_BUCKETS) ? bucket : STATS_BUCKETS - 1;
+}
+
+// The latency (microseconds, the middle of the bucket) of the fraction of barcodes
+static double StatsPercentile(const stats_t *stats, double fraction)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) total += stats->latency[i];
+    if (total == 0) return 0;
+    uint64_t target = (uint64_t)(fraction * (double)total);
+    if (target >= total) target = total - 1;
+    uint64_t count = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++)
+    {
+        count += stats->latency[i];
+        if (count > target)
+        {
+            if (i < STATS_SUBBUCKETS) return i * 1e-3;
+            int exponent = i / STATS_SUBBUCKETS + 2;
+            double width = (double)((uint64_t)1 << (exponent - 3));
+            return ((STATS_SUBBUCKETS + i % STATS_SUBBUCKETS) * width + width / 2) * 1e-3;
+        }
+    }
+    return 0;
+}
+
+// Reports the statistics as a JSON object on a single line
+static void StatsPrint(FILE *fp, const stats_t *stats)
+{
+    fprintf(fp, "{ \"elapsed_seconds\": %.3f, \"barcodes\": %" PRIu64 ", \"encode_errors\": %" PRIu64 ", \"verify_errors\": %" PRIu64 ", \"symbols\": %" PRIu64 ", \"code_changes\": %" PRIu64 ", \"bytes_rendered\": %" PRIu64 ", \"bytes_written\": %" PRIu64 ", ",
+        OutputTime() - statsStart, stats->barcodes, stats->encodeErrors, stats->verifyErrors, stats->symbols, stats->codeChanges, stats->bytesRendered, stats->bytesWritten);
+    fprintf(fp, "\"seconds\": { \"encode\": %.6f, \"verify\": %.6f, \"render\": %.6f, \"write\": %.6f }, \"latency_us\": { \"p50\": %.3f, \"p99\": %.3f } }\n",
+        stats->encodeTime, stats->verifyTime, stats->renderTime, stats->writeTime, StatsPercentile(stats, 0.50), StatsPercentile(stats, 0.99));
+    fflush(fp);
+}
+#else
+#define STATS(_code)
+#endif
+
+#define ENCODER_CHECKPOINTS (PREFIX_CACHE_MAX_LENGTH + 2)
+
+// An encoder state within the previous value, to resume a value sharing the prefix
+typedef struct
+{
+    size_t position;        // Characters encoded
+    barcode_t state;
+} encoder_checkpoint_t;
+
+// Encodes values to a bitmap (grown as required).  When resuming (--sequence or --prefix-cache), it keeps the encoder states at a few positions of the previous value (after the leading quiet zone, the prefix shared with the value before, and the separators within the cached prefix length), so that a value sharing a prefix with the previous one (e.g. a serial number) only re-encodes from the last of them in the shared prefix
+typedef struct
+{
+    uint8_t *bitmap;
+    size_t bitmapSize;
+    encoder_checkpoint_t checkpoints[ENCODER_CHECKPOINTS];  // (in order of position, each matching the previous value and bitmap)
+    int numCheckpoints;
+    char *previous;         // The previous value (which may contain NUL)
+    size_t previousLength;
+    size_t capacity;        // Characters allocated for the previous value
+    bool valid;
+    int quietZone;          // Quiet zone and code of the states
+    barcode_code_t fixedCode;
+    prefix_cache_t cache;   // Optional cache of prefix states (capacity 0 when disabled)
+    size_t numSymbols;      // Symbols of the last value encoded
+    size_t numCodeChanges;
+#ifndef NO_STATS
+    stats_t stats;
+#endif
+} encoder_t;
+
+// Totals of the prefix caches of the freed encoders
+static unsigned long prefixCacheHits = 0;
+static unsigned long prefixCacheMisses = 0;
+
+static void EncoderInit(encoder_t *encoder)
+{
+    memset(encoder, 0, sizeof(encoder_t));
+}
+
+static void EncoderFree(encoder_t *encoder)
+{
+    prefixCacheHits += encoder->cache.hits;
+    prefixCacheMisses += encoder->cache.misses;
+    PrefixCacheFree(&encoder->cache);
+    STATS(StatsMerge(&statsTotal, &encoder->stats));
+    free(encoder->bitmap);
+    free(encoder->previous);
+    memset(encoder, 0, sizeof(encoder_t));
+}
+
+// Whether the character ends a field whose prefix is cached (punctuation or space)
+static bool EncoderSeparator(char c)
+{
+    unsigned char u = (unsigned char)c;
+    return (u >= 0x20 && u < 0x7f) && !(u >= '0' && u <= '9') && !(u >= 'A' && u <= 'Z') && !(u >= 'a' && u <= 'z');
+}
+
+// Keeps the state after a position of the value (replacing the last, furthest, checkpoint when full)
+static void EncoderCheckpoint(encoder_t *encoder, size_t position, const barcode_t *state)
+{
+    if (encoder->numCheckpoints > 0 && encoder->checkpoints[encoder->numCheckpoints - 1].position >= position) return;
+    if (encoder->numCheckpoints >= ENCODER_CHECKPOINTS) encoder->numCheckpoints--;
+    encoder->checkpoints[encoder->numCheckpoints].position = position;
+    encoder->checkpoints[encoder->numCheckpoints].state = *state;
+    encoder->numCheckpoints++;
+}
+
+// Encodes the value to the state, resuming from the last checkpoint in the prefix shared with the previous value, or a longer cached prefix
+static void EncoderAppend(encoder_t *encoder, const options_t *options, const char *value, size_t valueLength, barcode_t *barcode)
+{
+    size_t shared = 0;
+    if (encoder->valid)
+    {
+        while (shared < valueLength && shared < encoder->previousLength && value[shared] == encoder->previous[shared]) shared++;
+    }
+    else
+    {
+        encoder->numCheckpoints = 0;
+    }
+
+    // The checkpoints within the shared prefix stay valid, the others are replaced by this value's
+    int kept = 0;
+    while (kept < encoder->numCheckpoints && encoder->checkpoints[kept].position <= shared) kept++;
+    encoder->numCheckpoints = kept;
+    size_t prefix = 0;
+    if (kept > 0)
+    {
+        prefix = encoder->checkpoints[kept - 1].position;
+        *barcode = encoder->checkpoints[kept - 1].state;
+    }
+
+    prefix_cache_t *cache = &encoder->cache;
+    uint32_t hashes[PREFIX_CACHE_MAX_LENGTH + 1];
+    size_t hashed = (valueLength < PREFIX_CACHE_MAX_LENGTH) ? valueLength : PREFIX_CACHE_MAX_LENGTH;
+    if (cache->capacity > 0)
+    {
+        PrefixHashes(hashes, value, hashed);
+        int index = -1;
+        for (size_t length = hashed; length > prefix && index < 0; length--) index = PrefixCacheFind(cache, hashes[length], value, length);
+        if (index >= 0)
+        {
+            prefix_entry_t *entry = &cache->entries[index];
+            prefix = entry->length;
+            memcpy(encoder->bitmap, cache->bytes + (size_t)index * cache->bytesPerEntry, entry->written);
+            *barcode = entry->state;
+            BarcodeResume(barcode, encoder->bitmap, encoder->bitmapSize);
+            EncoderCheckpoint(encoder, prefix, barcode);
+            cache->hits++;
+        }
+        else if (hashed > prefix)
+        {
+            cache->misses++;
+        }
+    }
+    if (encoder->numCheckpoints == 0)
+    {
+        BarcodeInit(barcode, encoder->bitmap, encoder->bitmapSize, options->quiet, options->fixedCode);
+        EncoderCheckpoint(encoder, 0, barcode);
+    }
+
+    // The value is encoded in spans, stopping to keep the state after the shared prefix, and to cache it and the state after each separator
+    if (cache->capacity > 0 && prefix == shared && shared <= hashed) PrefixCacheInsert(cache, hashes[shared], value, shared, barcode, encoder->bitmap);
+    for (size_t position = prefix; position < valueLength; )
+    {
+        size_t stop = (shared > position) ? shared : valueLength;
+        if (cache->capacity > 0)
+        {
+            for (size_t i = position; i < hashed && i + 1 < stop; i++)
+            {
+                if (EncoderSeparator(value[i])) { stop = i + 1; break; }
+            }
+        }
+        BarcodeAppend(barcode, value + position, stop - position);
+        position = stop;
+        if (position == valueLength) break;
+        EncoderCheckpoint(encoder, position, barcode);
+        if (cache->capacity > 0 && position <= hashed) PrefixCacheInsert(cache, hashes[position], value, position, barcode, encoder->bitmap);
+    }
+    if (valueLength > 0) memcpy(encoder->previous, value, valueLength);
+    encoder->previousLength = valueLength;
+    encoder->valid = true;
+}
+
+// Encodes the value (which may contain NUL, e.g. from a newline-delimited record) to the encoder's bitmap, returns the length in bars/bits (0 if it cannot be encoded) -- the bitmap is identical to encoding the value from scratch
+static size_t EncoderEncode(encoder_t *encoder, const options_t *options, const char *value, size_t valueLength)
+{
+    barcode_t barcode;
+    bool optimal = options->fixedCode == BARCODE_CODE_OPTIMAL;     // (the optimal coding needs the whole value, which may contain NUL, so cannot be resumed)
+    if (!options->resume || optimal)
+    {
+        // Measure first, so the bitmap is only grown to the exact size required
+        BarcodeInit(&barcode, NULL, 0, options->quiet, options->fixedCode);
+        if (optimal) BarcodeAppendOptimal(&barcode, value, valueLength); else BarcodeAppend(&barcode, value, valueLength);
+        size_t width = BarcodeFinish(&barcode);
+        encoder->numSymbols = BarcodeSymbols(&barcode, &encoder->numCodeChanges);
+        if (width == 0) return 0;
+        size_t requiredSize = BARCODE_SIZE(width);
+        if (requiredSize > encoder->bitmapSize)
+        {
+            uint8_t *bitmap = (uint8_t *)realloc(encoder->bitmap, requiredSize);
+            if (bitmap == NULL) { fprintf(stderr, "ERROR: Out of memory for barcode bitmap.\n"); return 0; }
+            encoder->bitmap = bitmap;
+            encoder->bitmapSize = requiredSize;
+        }
+        encoder->valid = false;
+        memset(encoder->bitmap, 0, requiredSize);
+        BarcodeInit(&barcode, encoder->bitmap, requiredSize, options->quiet, options->fixedCode);
+        if (optimal) BarcodeAppendOptimal(&barcode, value, valueLength); else BarcodeAppend(&barcode, value, valueLength);
+        width = BarcodeFinish(&barcode);
+        encoder->numSymbols = BarcodeSymbols(&barcode, &encoder->numCodeChanges);
+        return width;
+    }
+
+    // Grow the bitmap to the largest possible width (each character adds at most a code change and a symbol), invalidating the states (which point into it)
+    int quiet = (options->quiet > 0) ? options->quiet : 0;
+    size_t requiredSize = BARCODE_SIZE(2 * (size_t)quiet + (2 * valueLength + 3) * 11 + 2);
+    if (requiredSize > encoder->bitmapSize)
+    {
+        size_t size = encoder->bitmapSize ? encoder->bitmapSize : 64;
+        while (size < requiredSize) size *= 2;
+        uint8_t *bitmap = (uint8_t *)realloc(encoder->bitmap, size);
+        if (bitmap == NULL) { fprintf(stderr, "ERROR: Out of memory for barcode bitmap.\n"); return 0; }
+        encoder->bitmap = bitmap;
+        encoder->bitmapSize = size;
+        encoder->valid = false;
+    }
+
+    // The states (and cached prefixes) are only for the same quiet zone and code
+    if (options->quiet != encoder->quietZone || options->fixedCode != encoder->fixedCode)
+    {
+        encoder->valid = false;
+        if (encoder->cache.capacity > 0) PrefixCacheClear(&encoder->cache);
+        encoder->quietZone = options->quiet;
+        encoder->fixedCode = options->fixedCode;
+    }
+
+    if (valueLength > encoder->capacity)
+    {
+        size_t capacity = encoder->capacity ? encoder->capacity : 32;
+        while (capacity < valueLength) capacity *= 2;
+        char *previous = (char *)realloc(encoder->previous, capacity);
+        if (previous == NULL) { fprintf(stderr, "ERROR: Out of memory for barcode encoder.\n"); return 0; }
+        encoder->previous = previous;
+        encoder->capacity = capacity;
+    }
+
+    if (options->prefixCache > 0 && encoder->cache.capacity == 0 && !PrefixCacheInit(&encoder->cache, options->prefixCache, options->quiet))
+    {
+        PrefixCacheFree(&encoder->cache);
+        fprintf(stderr, "ERROR: Out of memory for prefix cache.\n");
+        return 0;
+    }
+
+    EncoderAppend(encoder, options, value, valueLength, &barcode);
+    size_t width = BarcodeFinish(&barcode);
+    encoder->numSymbols = BarcodeSymbols(&barcode, &encoder->numCodeChanges);
+
+    // Clear the unused bits of the final byte (left from a previous, longer, value), as when encoding to a cleared bitmap
+    if (width & 7)
+    {
+#ifdef BARCODE_MSB_FIRST
+        encoder->bitmap[width >> 3] &= (uint8_t)(0xff00 >> (width & 7));
+#else
+        encoder->bitmap[width >> 3] &= (uint8_t)((1 << (width & 7)) - 1);
+#endif
+    }
+    return width;
+}
+
+#ifndef NO_STATS
+// Times the stages of generating a barcode (when the statistics are enabled)
+typedef struct
+{
+    stats_t *stats;             // NULL when not enabled
+    const output_t *out;
+    double start;
+    double time;                // End of the previous stage
+    uint64_t output;            // Output bytes before the barcode
+    double writeTime;           // Output write time before the barcode
+} stats_timer_t;
+
+static void StatsStart(stats_timer_t *timer, const options_t *options, encoder_t *encoder, const output_t *out)
+{
+    memset(timer, 0, sizeof(stats_timer_t));
+    timer->stats = options->stats ? &encoder->stats : NULL;
+    if (timer->stats == NULL) return;
+    timer->out = out;
+    timer->output = out->written + out->length;
+    timer->writeTime = out->writeTime;
+    timer->start = timer->time = OutputTime();
+}
+
+// Ends a stage, adding its time
+static void StatsStage(stats_timer_t *timer, double *stageTime)
+{
+    double now = OutputTime();
+    *stageTime += now - timer->time;
+    timer->time = now;
+}
+
+static void StatsEncoded(stats_timer_t *timer, const encoder_t *encoder, size_t length)
+{
+    if (timer->stats == NULL) return;
+    StatsStage(timer, &timer->stats->encodeTime);
+    if (length == 0) { timer->stats->encodeErrors++; return; }
+    timer->stats->symbols += encoder->numSymbols;
+    timer->stats->codeChanges += encoder->numCodeChanges;
+}
+
+static void StatsVerified(stats_timer_t *timer, bool verified)
+{
+    if (timer->stats == NULL) return;
+    StatsStage(timer, &timer->stats->verifyTime);
+    if (!verified) timer->stats->verifyErrors++;
+}
+
+static void StatsRendered(stats_timer_t *timer)
+{
+    if (timer->stats == NULL) return;
+    stats_t *stats = timer->stats;
+    double now = OutputTime();
+    double writeTime = timer->out->writeTime - timer->writeTime;    // Writes when the file buffer filled during rendering (counted for the output)
+    stats->renderTime += now - timer->time - writeTime;
+    stats->bytesRendered += timer->out->written + timer->out->length - timer->output;
+    stats->barcodes++;
+    stats->latency[StatsBucket((uint64_t)((now - timer->start - writeTime) * 1e9))]++;
+}
+
+// Reports the statistics so far, if periodic reports are due (only from the thread generating)
+static void StatsPeriodic(const options_t *options, const encoder_t *encoder, const output_t *out)
+{
+    if (!options->stats || options->statsInterval <= 0) return;
+    double now = OutputTime();
+    if (now < statsNext) return;
+    statsNext = now + options->statsInterval;
+    stats_t stats = statsTotal;
+    if (encoder != NULL) StatsMerge(&stats, &encoder->stats);
+    if (out != NULL) StatsOutput(&stats, out);
+    StatsPrint(stderr, &stats);
+}
+#endif
+
+// Checks the barcode bitmap decodes back to the value
+static bool VerifyBarcode(const uint8_t *bitmap, size_t length, const char *value, size_t valueLength)
+{
+    char decoded[256];
+    char *text = (valueLength < sizeof(decoded)) ? decoded : (char *)malloc(valueLength + 1);
+    bool checksumValid = false;
+    size_t decodedLength = (text != NULL) ? BarcodeDecode(text, valueLength + 1, bitmap, length, &checksumValid) : BARCODE_DECODE_ERROR;
+    bool verified = decodedLength == valueLength && checksumValid && memcmp(text, value, valueLength) == 0;
+    if (text != decoded) free(text);
+    return verified;
+}
+
+// Parses a rotation in degrees (clockwise)
+static bool RotationParse(barcode_rotation_t *rotation, const char *text)
+{
+    if (!strcmp(text, "0")) *rotation = BARCODE_ROTATE_0;
+    else if (!strcmp(text, "90")) *rotation = BARCODE_ROTATE_90;
+    else if (!strcmp(text, "180")) *rotation = BARCODE_ROTATE_180;
+    else if (!strcmp(text, "270")) *rotation = BARCODE_ROTATE_270;
+    else return false;
+    return true;
+}
+
+// Whether the rotation is supported by the output mode: a half-turn is the reversed bitmap (every row is the same), for any renderer but the information, and the ladder orientation is rasterized for the BMP and PNG images
+static bool RotationSupported(barcode_rotation_t rotation, output_mode_t outputMode)
+{
+    if (rotation == BARCODE_ROTATE_0) return true;
+    if (outputMode == OUTPUT_IMAGE_BITMAP || outputMode == OUTPUT_PNG) return true;
+    return rotation == BARCODE_ROTATE_180 && outputMode != OUTPUT_INFO;
+}
+
+// Writes the bitmap reversed
+static void ReverseBitmap(uint8_t *reversed, const uint8_t *bitmap, size_t length)
+{
+    memset(reversed, 0, BARCODE_SIZE(length));
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!BARCODE_BIT(bitmap, length - 1 - i)) continue;
+#ifdef BARCODE_MSB_FIRST
+        reversed[i >> 3] |= (uint8_t)(0x80 >> (i & 7));
+#else
+        reversed[i >> 3] |= (uint8_t)(0x01 << (i & 7));
+#endif
+    }
+}
+
+// Generates the barcode for a value and renders it with the selected output mode, using (and growing) the encoder's bitmap
+static bool GenerateBarcode(output_t *out, const options_t *options, const char *value, size_t valueLength, encoder_t *encoder)
+{
+    STATS(stats_timer_t timer);
+    STATS(StatsStart(&timer, options, encoder, out));
+
+    // Generates the barcode as a bitmap (0=black, 1=white), returns the length in bars/bits. Optionally adds a 10-unit quiet zone either side.
+    size_t length = EncoderEncode(encoder, options, value, valueLength);
+    STATS(StatsEncoded(&timer, encoder, length));
+    if (length == 0) { fprintf(stderr, "ERROR: Value cannot be encoded%s: %.*s\n", options->fixedCode != BARCODE_CODE_NONE ? " with the specified code" : "", (int)valueLength, value); return false; }
+    uint8_t *bitmap = encoder->bitmap;
+
+    // Check the barcode decodes back to the value before rendering it
+    if (options->verify)
+    {
+        bool verified = VerifyBarcode(bitmap, length, value, valueLength);
+        STATS(StatsVerified(&timer, verified));
+        if (!verified) { fprintf(stderr, "ERROR: Barcode failed verification: %.*s\n", (int)valueLength, value); return false; }
+    }
+
+    // Rotated BMP and PNG images are rasterized in the orientation, and the other renderers are given the bitmap reversed for a half-turn (the encoder's bitmap is kept for the next value)
+    uint8_t reversed[256];
+    uint8_t *reversedBitmap = NULL;
+    if (options->rotation == BARCODE_ROTATE_180 && options->outputMode != OUTPUT_IMAGE_BITMAP && options->outputMode != OUTPUT_PNG)
+    {
+        reversedBitmap = (BARCODE_SIZE(length) <= sizeof(reversed)) ? reversed : (uint8_t *)malloc(BARCODE_SIZE(length));
+        if (reversedBitmap == NULL) { fprintf(stderr, "ERROR: Out of memory for barcode bitmap.\n"); return false; }
+        ReverseBitmap(reversedBitmap, bitmap, length);
+        bitmap = reversedBitmap;
+    }
+
+    switch (options->outputMode)
+    {
+        case OUTPUT_INFO: OutputBarcodeInfo(out, bitmap, length, value, valueLength); break;
+        case OUTPUT_TEXT_WIDE: OutputBarcodeTextWide(out, bitmap, length, options->scale, options->height, options->invert); break;
+        case OUTPUT_TEXT_NARROW: OutputBarcodeTextNarrow(out, bitmap, length, options->scale, options->height, options->invert); break;
+        case OUTPUT_IMAGE_BITMAP:
+            if (options->rotation != BARCODE_ROTATE_0) OutputBarcodeImageBitmapRotated(out, bitmap, length, options->scale, options->height, options->invert, options->rotation);
+            else OutputBarcodeImageBitmap(out, bitmap, length, options->scale, options->height, options->invert);
+            break;
+        case OUTPUT_PNG:
+            if (options->rotation != BARCODE_ROTATE_0) OutputBarcodePngRotated(out, bitmap, length, options->scale, options->height, options->invert, options->rotation);
+            else OutputBarcodePng(out, bitmap, length, options->scale, options->height, options->invert);
+            break;
+        case OUTPUT_SVG: OutputBarcodeSvg(out, bitmap, length, options->moduleSize, options->height, options->invert); break;
+        case OUTPUT_PDF: OutputBarcodePdf(out, bitmap, length, options->moduleSize, options->height, options->invert); break;
+        case OUTPUT_SIXEL: OutputBarcodeSixel(out, bitmap, length, options->scale, options->height, options->invert); break;
+        case OUTPUT_TGP: OutputBarcodeTerminalGraphicsProtocol(out, bitmap, length, options->scale, options->height, options->invert); break;
+        case OUTPUT_ZPL: OutputBarcodeZpl(out, bitmap, length, options->scale, options->height, options->invert); break;
+        case OUTPUT_EPL: OutputBarcodeEpl(out, bitmap, length, options->scale, options->height, options->invert); break;
+        default: OutputPrintf(out, "<error>"); break;
+    }
+    if (reversedBitmap != NULL && reversedBitmap != reversed) free(reversedBitmap);
+    STATS(StatsRendered(&timer));
+    return true;
+}
+
+// Generates the barcode for a record of a batch, to the output stream or to a file named from the template
+static bool GenerateRecord(output_t *out, const options_t *options, const char *fileTemplate, unsigned long recordNumber, const char *record, size_t recordLength, encoder_t *encoder)
+{
+    bool generated;
+    char filename[1024];
+    if (fileTemplate != NULL)
+    {
+        if (!ExpandTemplate(filename, sizeof(filename), fileTemplate, recordNumber, record, recordLength)) { fprintf(stderr, "ERROR: Invalid output filename template: %s\n", fileTemplate); return false; }
+        FILE *fp = fopen(filename, "wb");
+        if (fp == NULL) { fprintf(stderr, "ERROR: Unable to open output filename: %s\n", filename); return false; }
+        output_t fileOutput;
+        OutputInit(&fileOutput, fp);
+        STATS(if (options->stats) { setvbuf(fp, NULL, _IONBF, 0); fileOutput.timed = true; });
+        generated = GenerateBarcode(&fileOutput, options, record, recordLength, encoder);
+        OutputFree(&fileOutput);
+        STATS(if (options->stats) StatsOutput(&encoder->stats, &fileOutput));
+        fclose(fp);
+        if (!generated) remove(filename);
+    }
+    else
+    {
+        generated = GenerateBarcode(out, options, record, recordLength, encoder);
+    }
+    // Report unencodable records, but continue with the rest of the batch
+    if (!generated) fprintf(stderr, "ERROR: Record %lu not generated.\n", recordNumber);
+    return generated;
+}
+
+// Generates a barcode for every record of the input, to a single output stream or to per-record files
+static int GenerateBatch(record_reader_t *reader, output_t *out, const char *fileTemplate, const options_t *options)
+{
+    encoder_t encoder;
+    EncoderInit(&encoder);
+    unsigned long recordNumber = 0;
+    int result = 0;
+    const char *record;
+    size_t recordLength;
+    while (RecordReaderNext(reader, &record, &recordLength))
+    {
+        if (!GenerateRecord(out, options, fileTemplate, ++recordNumber, record, recordLength, &encoder)) result = -1;
+        STATS(StatsPeriodic(options, &encoder, out));
+    }
+    EncoderFree(&encoder);
+    return result;
+}
+
+
+// Sequence numbers to generate, from the start to the end (inclusive), in steps (which may be negative)
+typedef struct
+{
+    unsigned long start;
+    unsigned long end;
+    long step;
+} sequence_t;
+
+static bool SequenceParse(sequence_t *sequence, const char *text)
+{
+    char *end;
+    sequence->step = 1;
+    sequence->start = strtoul(text, &end, 10);
+    if (end == text || *end++ != ':') return false;
+    text = end;
+    sequence->end = strtoul(text, &end, 10);
+    if (end == text) return false;
+    if (*end == ':')
+    {
+        text = end + 1;
+        sequence->step = strtol(text, &end, 10);
+        if (end == text || sequence->step == 0) return false;
+    }
+    return *end == '\0';
+}
+
+// Generates a barcode for every number of the sequence, each value from the template (e.g. LOT42-%06n), where consecutive values share a prefix so only their changed tail is re-encoded
+static int GenerateSequence(const sequence_t *sequence, const char *valueTemplate, output_t *out, const char *fileTemplate, const options_t *options)
+{
+    unsigned long step = (sequence->step > 0) ? (unsigned long)sequence->step : 0 - (unsigned long)sequence->step;
+    unsigned long count = 0;
+    if (sequence->step > 0 && sequence->end >= sequence->start) count = (sequence->end - sequence->start) / step + 1;
+    if (sequence->step < 0 && sequence->start >= sequence->end) count = (sequence->start - sequence->end) / step + 1;
+
+    encoder_t encoder;
+    EncoderInit(&encoder);
+    int result = 0;
+    char value[1024];
+    for (unsigned long i = 0; i < count; i++)
+    {
+        unsigned long number = (sequence->step > 0) ? sequence->start + i * step : sequence->start - i * step;
+        if (!ExpandTemplate(value, sizeof(value), valueTemplate, number, "", 0)) { fprintf(stderr, "ERROR: Invalid sequence value template: %s\n", valueTemplate); result = -1; break; }
+        if (!GenerateRecord(out, options, fileTemplate, number, value, strlen(value), &encoder)) result = -1;
+        STATS(StatsPeriodic(options, &encoder, out));
+    }
+    EncoderFree(&encoder);
+    return result;
+}
+
+
+// Layout of a multi-up sheet: a grid of cells, each a barcode (centered, with its quiet zone) and optionally its value as a line of text below, separated by gutters
+typedef struct
+{
+    int columns;
+    int rows;
+    int gutterX;        // Pixels between columns
+    int gutterY;        // Pixels between rows
+    bool label;         // Value as human-readable text below each barcode
+} sheet_t;
+
+// Parses a pair of numbers "AxB" (or a single number "A" if the second is optional, the same for both)
+static bool SheetPair(const char *text, int *first, int *second, bool optional, int minimum)
+{
+    char *end;
+    long a = strtol(text, &end, 10);
+    long b = a;
+    if (end == text || (*end != 'x' && (*end != '\0' || !optional))) return false;
+    if (*end == 'x')
+    {
+        text = end + 1;
+        b = strtol(text, &end, 10);
+        if (end == text || *end != '\0') return false;
+    }
+    if (a < minimum || b < minimum || a > 65535 || b > 65535) return false;
+    *first = (int)a;
+    *second = (int)b;
+    return true;
+}
+
+// A cell of the current page: its bitmap and value are kept (in the page's arena) until the page is written
+typedef struct
+{
+    size_t offset;      // Arena offset of the bitmap, followed by the value
+    size_t length;      // Length of the bitmap in bars/bits (0 if the value was not encoded)
+    size_t valueLength;
+} sheet_cell_t;
+
+// A page being written, one scanline at a time
+typedef struct
+{
+    output_t *out;
+    output_png_t *png;  // PNG writer, or NULL for BMP
+    int width;
+    uint8_t *row;       // Scanline (padded for BMP)
+    size_t rowBytes;    // Bytes of pixels in the scanline
+    bool invert;
+} sheet_page_t;
+
+// Writes the scanline to the page a number of times
+static void SheetEmit(sheet_page_t *page, int count)
+{
+    if (page->invert)
+    {
+        for (size_t i = 0; i < page->rowBytes; i++) page->row[i] ^= 0xff;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (page->png != NULL) OutputPngRow(page->png, page->row);
+        else OutputBitmapRow(page->out, page->width, page->row);
+    }
+}
+
+// Writes a page of cells, a band (row of cells) at a time: the bars are the same for every row of the band, so the band's scanline is composed once (each barcode rasterized at its cell's offset) and repeated for the height, then the text rows, so only a single scanline of the page is ever held
+static void SheetWritePage(output_t *out, const options_t *options, const sheet_t *sheet, const sheet_cell_t *cells, int numCells, const uint8_t *arena, int cellWidth, int width, int height, uint8_t *row)
+{
+    sheet_page_t page = {0};
+    page.out = out;
+    page.width = width;
+    page.row = row;
+    page.rowBytes = ((size_t)width + 7) / 8;
+    page.invert = options->invert;
+    memset(row, 0x00, OUTPUT_BITMAP_SPAN(width));
+    if (options->outputMode == OUTPUT_PNG)
+    {
+        page.png = (output_png_t *)malloc(sizeof(output_png_t));
+        out->allocations++;
+        if (page.png == NULL) { fprintf(stderr, "ERROR: Out of memory for PNG.\n"); return; }
+        OutputPngBegin(page.png, out, width, height);
+    }
+    else
+    {
+        OutputBitmapBegin(out, width, height);
+    }
+
+    int textHeight = sheet->label ? OUTPUT_FONT_HEIGHT * options->scale : 0;
+    for (int band = 0; band < sheet->rows; band++)
+    {
+        if (band > 0 && sheet->gutterY > 0)
+        {
+            memset(row, 0xff, page.rowBytes);
+            SheetEmit(&page, sheet->gutterY);
+        }
+
+        memset(row, 0xff, page.rowBytes);
+        for (int column = 0; column < sheet->columns; column++)
+        {
+            int index = band * sheet->columns + column;
+            if (index >= numCells || cells[index].length == 0) continue;
+            size_t barWidth = cells[index].length * options->scale;
+            size_t x = (size_t)column * (cellWidth + sheet->gutterX) + (cellWidth - barWidth) / 2;
+            BarcodeRasterize(row, 0, BARCODE_RASTER_1BPP, x, 0, arena + cells[index].offset, cells[index].length, options->scale, 0, 1, false);
+        }
+        SheetEmit(&page, options->height);
+
+        for (int y = 0; y < textHeight; y++)
+        {
+            memset(row, 0xff, page.rowBytes);
+            for (int column = 0; column < sheet->columns; column++)
+            {
+                int index = band * sheet->columns + column;
+                if (index >= numCells) continue;
+                const sheet_cell_t *cell = &cells[index];
+                size_t textWidth = cell->valueLength * OUTPUT_FONT_WIDTH * options->scale;
+                size_t left = (size_t)column * (cellWidth + sheet->gutterX);
+                size_t x = left + ((textWidth < (size_t)cellWidth) ? ((size_t)cellWidth - textWidth) / 2 : 0);
+                OutputTextRow(row, x, left + cellWidth, (const char *)arena + cell->offset + BARCODE_SIZE(cell->length), cell->valueLength, options->scale, y);
+            }
+            SheetEmit(&page, 1);
+        }
+    }
+
+    if (page.png != NULL)
+    {
+        OutputPngEnd(page.png);
+        free(page.png);
+    }
+}
+
+// Generates multi-up sheets of the barcodes for the records of the input (as BMP or PNG pages), to a single output stream or to per-page files
+static int GenerateSheet(record_reader_t *reader, output_t *out, const char *fileTemplate, const options_t *options, const sheet_t *sheet)
+{
+    int cellsPerPage = sheet->columns * sheet->rows;
+    sheet_cell_t *cells = (sheet_cell_t *)malloc(cellsPerPage * sizeof(sheet_cell_t));
+    uint8_t *arena = NULL;
+    size_t arenaCapacity = 0;
+    uint8_t *row = NULL;
+    size_t rowCapacity = 0;
+    if (cells == NULL) { fprintf(stderr, "ERROR: Out of memory for sheet.\n"); return -1; }
+
+    encoder_t encoder;
+    EncoderInit(&encoder);
+    unsigned long recordNumber = 0;
+    unsigned long pageNumber = 0;
+    int result = 0;
+    const char *record;
+    size_t recordLength;
+    for (bool more = true; more; )
+    {
+        // Encode the values of the page (the bitmaps and values are small compared with the page's pixels), finding the widest cell
+        int numCells = 0;
+        size_t arenaLength = 0;
+        size_t cellWidth = 1;
+        while (numCells < cellsPerPage && (more = RecordReaderNext(reader, &record, &recordLength)))
+        {
+            sheet_cell_t *cell = &cells[numCells++];
+            recordNumber++;
+            STATS(stats_timer_t timer);
+            STATS(StatsStart(&timer, options, &encoder, out));
+            size_t length = EncoderEncode(&encoder, options, record, recordLength);
+            STATS(StatsEncoded(&timer, &encoder, length));
+            if (length == 0) fprintf(stderr, "ERROR: Value cannot be encoded%s: %.*s\n", options->fixedCode != BARCODE_CODE_NONE ? " with the specified code" : "", (int)recordLength, record);
+            if (length > 0 && options->verify)
+            {
+                bool verified = VerifyBarcode(encoder.bitmap, length, record, recordLength);
+                STATS(StatsVerified(&timer, verified));
+                if (!verified) { fprintf(stderr, "ERROR: Barcode failed verification: %.*s\n", (int)recordLength, record); length = 0; }
+            }
+            if (length == 0) { fprintf(stderr, "ERROR: Record %lu not generated.\n", recordNumber); result = -1; }
+            STATS(StatsRendered(&timer));
+
+            // A cell that was not generated is left blank, but still labelled
+            size_t size = BARCODE_SIZE(length) + recordLength;
+            if (arenaLength + size > arenaCapacity)
+            {
+                size_t capacity = arenaCapacity ? arenaCapacity : 4096;
+                while (capacity < arenaLength + size) capacity *= 2;
+                uint8_t *newArena = (uint8_t *)realloc(arena, capacity);
+                if (newArena == NULL) { fprintf(stderr, "ERROR: Out of memory for sheet.\n"); result = -1; more = false; numCells--; break; }
+                arena = newArena;
+                arenaCapacity = capacity;
+            }
+            cell->offset = arenaLength;
+            cell->length = length;
+            cell->valueLength = recordLength;
+            memcpy(arena + arenaLength, encoder.bitmap, BARCODE_SIZE(length));
+            memcpy(arena + arenaLength + BARCODE_SIZE(length), record, recordLength);
+            arenaLength += size;
+
+            size_t width = length * options->scale;
+            size_t textWidth = sheet->label ? recordLength * OUTPUT_FONT_WIDTH * options->scale : 0;
+            if (width > cellWidth) cellWidth = width;
+            if (textWidth > cellWidth) cellWidth = textWidth;
+            STATS(StatsPeriodic(options, &encoder, out));
+        }
+        if (numCells == 0) break;
+
+        // Every page is the whole grid (any cells after the last record are blank)
+        size_t cellHeight = (size_t)options->height + (sheet->label ? OUTPUT_FONT_HEIGHT * (size_t)options->scale : 0);
+        size_t width = sheet->columns * cellWidth + (sheet->columns - 1) * (size_t)sheet->gutterX;
+        size_t height = sheet->rows * cellHeight + (sheet->rows - 1) * (size_t)sheet->gutterY;
+        pageNumber++;
+        if (width > 0x7fffffff / 2 || height > 0x7fffffff / 2 || height == 0) { fprintf(stderr, "ERROR: Sheet page %lu is too large: %lu x %lu\n", pageNumber, (unsigned long)width, (unsigned long)height); result = -1; continue; }
+        if (OUTPUT_BITMAP_SPAN(width) > rowCapacity)
+        {
+            free(row);
+            rowCapacity = OUTPUT_BITMAP_SPAN(width);
+            row = (uint8_t *)malloc(rowCapacity);
+            if (row == NULL) { fprintf(stderr, "ERROR: Out of memory for sheet scanline.\n"); result = -1; break; }
+        }
+
+        // Each page to the output stream, or to a file named from the template (the page number, and the first value)
+        output_t fileOutput;
+        output_t *target = out;
+        FILE *fp = NULL;
+        if (fileTemplate != NULL)
+        {
+            char filename[1024];
+            if (!ExpandTemplate(filename, sizeof(filename), fileTemplate, pageNumber, (const char *)arena + BARCODE_SIZE(cells[0].length), cells[0].valueLength)) { fprintf(stderr, "ERROR: Invalid output filename template: %s\n", fileTemplate); result = -1; break; }
+            fp = fopen(filename, "wb");
+            if (fp == NULL) { fprintf(stderr, "ERROR: Unable to open output filename: %s\n", filename); result = -1; continue; }
+            OutputInit(&fileOutput, fp);
+            STATS(if (options->stats) { setvbuf(fp, NULL, _IONBF, 0); fileOutput.timed = true; });
+            target = &fileOutput;
+        }
+
+        // The page is counted as rendered (excluding the writes when the file buffer fills)
+        STATS(double pageStart = options->stats ? OutputTime() : 0; double pageWriteTime = target->writeTime; uint64_t pageOutput = target->written + target->length);
+        SheetWritePage(target, options, sheet, cells, numCells, arena, (int)cellWidth, (int)width, (int)height, row);
+        STATS(if (options->stats) { encoder.stats.renderTime += OutputTime() - pageStart - (target->writeTime - pageWriteTime); encoder.stats.bytesRendered += target->written + target->length - pageOutput; });
+
+        if (fp != NULL)
+        {
+            OutputFree(&fileOutput);
+            STATS(if (options->stats) StatsOutput(&encoder.stats, &fileOutput));
+            fclose(fp);
+        }
+    }
+    EncoderFree(&encoder);
+    free(row);
+    free(arena);
+    free(cells);
+    return result;
+}
+
+
+// Threads (for batch generation)
+#ifdef _WIN32
+typedef HANDLE thread_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+#define THREAD_FUNCTION DWORD WINAPI
+#define THREAD_RETURN 0
+static bool ThreadCreate(thread_t *thread, LPTHREAD_START_ROUTINE start, void *arg) { *thread = CreateThread(NULL, 0, start, arg, 0, NULL); return *thread != NULL; }
+static void ThreadJoin(thread_t thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+#define MutexInit(_m) InitializeCriticalSection(_m)
+#define MutexDestroy(_m) DeleteCriticalSection(_m)
+#define MutexLock(_m) EnterCriticalSection(_m)
+#define MutexUnlock(_m) LeaveCriticalSection(_m)
+#define CondInit(_c) InitializeConditionVariable(_c)
+#define CondDestroy(_c) ((void)(_c))
+#define CondWait(_c, _m) SleepConditionVariableCS((_c), (_m), INFINITE)
+#define CondBroadcast(_c) WakeAllConditionVariable(_c)
+static int ProcessorCount(void) { SYSTEM_INFO info; GetSystemInfo(&info); return (int)info.dwNumberOfProcessors; }
+#else
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+#define THREAD_FUNCTION void *
+#define THREAD_RETURN NULL
+static bool ThreadCreate(thread_t *thread, void *(*start)(void *), void *arg) { return pthread_create(thread, NULL, start, arg) == 0; }
+static void ThreadJoin(thread_t thread) { pthread_join(thread, NULL); }
+#define MutexInit(_m) pthread_mutex_init((_m), NULL)
+#define MutexDestroy(_m) pthread_mutex_destroy(_m)
+#define MutexLock(_m) pthread_mutex_lock(_m)
+#define MutexUnlock(_m) pthread_mutex_unlock(_m)
+#define CondInit(_c) pthread_cond_init((_c), NULL)
+#define CondDestroy(_c) pthread_cond_destroy(_c)
+#define CondWait(_c, _m) pthread_cond_wait((_c), (_m))
+#define CondBroadcast(_c) pthread_cond_broadcast(_c)
+static int ProcessorCount(void) { long count = sysconf(_SC_NPROCESSORS_ONLN); return count > 0 ? (int)count : 1; }
+#endif
+
+#define BATCH_MAX_THREADS 256
+#define BATCH_CHUNK_RECORDS 4096
+
+// A record of a chunk, and where its rendered output was placed
+typedef struct
+{
+    size_t offset;          // Start of the value in the chunk text, or in the memory-mapped input
+    bool inText;            // The value was copied to the chunk text
+    size_t valueLength;     // Length of the value (which may contain NUL)
+    int worker;             // Worker that rendered the record
+    size_t start;           // Start of the rendered output in the worker's output
+    size_t length;          // Length of the rendered output
+} batch_record_t;
+
+// A chunk of records from the input
+typedef struct
+{
+    batch_record_t records[BATCH_CHUNK_RECORDS];
+    size_t count;
+    const char *input;      // The memory-mapped input (if any)
+    char *text;             // Record values copied from the input (each NUL-terminated), back-to-back
+    size_t textLength;
+    size_t textCapacity;
+    unsigned long firstRecordNumber;
+} batch_chunk_t;
+
+typedef struct batch_pool batch_pool_t;
+
+typedef struct
+{
+    batch_pool_t *pool;
+    int index;
+    thread_t thread;
+    mutex_t mutex;          // Protects the deque
+    size_t head;            // Deque of the record indexes still to do: the worker takes from the head, other workers steal from the tail
+    size_t tail;
+    output_t output[2];     // Rendered output for alternate chunks (one is written while the other is rendered)
+    encoder_t encoder;
+    bool failed;
+} batch_worker_t;
+
+struct batch_pool
+{
+    const options_t *options;
+    const char *fileTemplate;
+    int numWorkers;
+    batch_worker_t workers[BATCH_MAX_THREADS];
+    mutex_t mutex;
+    cond_t start;
+    cond_t done;
+    unsigned int generation;    // Incremented to start each chunk
+    batch_chunk_t *chunk;       // Chunk being processed
+    int parity;                 // Output buffer for the chunk being processed
+    int active;                 // Workers yet to finish the chunk
+    bool quit;
+};
+
+// Takes the next record from the worker's own deque
+static bool BatchTake(batch_worker_t *worker, size_t *index)
+{
+    bool taken = false;
+    MutexLock(&worker->mutex);
+    if (worker->head < worker->tail)
+    {
+        *index = worker->head++;
+        taken = true;
+    }
+    MutexUnlock(&worker->mutex);
+    return taken;
+}
+
+// Steals the later half of the records remaining in another worker's deque, returns the first of them
+static bool BatchSteal(batch_worker_t *worker, size_t *index)
+{
+    batch_pool_t *pool = worker->pool;
+    for (int i = 1; i < pool->numWorkers; i++)
+    {
+        batch_worker_t *victim = &pool->workers[(worker->index + i) % pool->numWorkers];
+        size_t head = 0, tail = 0;
+        MutexLock(&victim->mutex);
+        if (victim->head < victim->tail)
+        {
+            tail = victim->tail;
+            head = victim->head + (victim->tail - victim->head) / 2;
+            victim->tail = head;
+        }
+        MutexUnlock(&victim->mutex);
+        if (head < tail)
+        {
+            MutexLock(&worker->mutex);
+            *index = head;
+            worker->head = head + 1;
+            worker->tail = tail;
+            MutexUnlock(&worker->mutex);
+            return true;
+        }
+    }
+    return false;
+}
+
+static THREAD_FUNCTION BatchWorker(void *arg)
+{
+    batch_worker_t *worker = (batch_worker_t *)arg;
+    batch_pool_t *pool = worker->pool;
+    unsigned int generation = 0;
+
+    MutexLock(&pool->mutex);
+    for (;;)
+    {
+        while (!pool->quit && pool->generation == generation) CondWait(&pool->start, &pool->mutex);
+        if (pool->quit) break;
+        generation = pool->generation;
+        batch_chunk_t *chunk = pool->chunk;
+        output_t *out = &worker->output[pool->parity];
+        MutexUnlock(&pool->mutex);
+
+        size_t index;
+        while (BatchTake(worker, &index) || BatchSteal(worker, &index))
+        {
+            batch_record_t *record = &chunk->records[index];
+            record->worker = worker->index;
+            record->start = out->length;
+            if (!GenerateRecord(out, pool->options, pool->fileTemplate, chunk->firstRecordNumber + index, (record->inText ? chunk->text : chunk->input) + record->offset, record->valueLength, &worker->encoder)) worker->failed = true;
+            record->length = out->length - record->start;
+        }
+
+        MutexLock(&pool->mutex);
+        if (--pool->active == 0) CondBroadcast(&pool->done);
+    }
+    MutexUnlock(&pool->mutex);
+    return THREAD_RETURN;
+}
+
+// Reads up to a chunk of records from the input (copied, unless the input is memory-mapped, so stays in place)
+static void BatchReadChunk(record_reader_t *reader, batch_chunk_t *chunk, unsigned long firstRecordNumber)
+{
+    const char *record;
+    size_t recordLength;
+    chunk->count = 0;
+    chunk->textLength = 0;
+    chunk->firstRecordNumber = firstRecordNumber;
+    while (chunk->count < BATCH_CHUNK_RECORDS && RecordReaderNext(reader, &record, &recordLength))
+    {
+        batch_record_t *batchRecord = &chunk->records[chunk->count];
+        batchRecord->valueLength = recordLength;
+
+        // A value in a memory-mapped input stays in place (but not a column unquoted to the reader's field buffer)
+        batchRecord->inText = !reader->mapped || record == reader->field;
+        if (!batchRecord->inText)
+        {
+            batchRecord->offset = (size_t)(record - reader->buffer);
+            chunk->count++;
+            continue;
+        }
+        if (chunk->textLength + recordLength + 1 > chunk->textCapacity)
+        {
+            size_t capacity = chunk->textCapacity ? chunk->textCapacity : RECORD_READER_BLOCK;
+            while (capacity < chunk->textLength + recordLength + 1) capacity *= 2;
+            char *text = (char *)realloc(chunk->text, capacity);
+            if (text == NULL) { fprintf(stderr, "ERROR: Out of memory for batch records.\n"); break; }
+            chunk->text = text;
+            chunk->textCapacity = capacity;
+        }
+        batchRecord->offset = chunk->textLength;
+        memcpy(chunk->text + chunk->textLength, record, recordLength);
+        chunk->text[chunk->textLength + recordLength] = '\0';
+        chunk->textLength += recordLength + 1;
+        chunk->count++;
+    }
+    chunk->input = reader->buffer;
+}
+
+// Divides the chunk between the workers' deques and starts them
+static void BatchStart(batch_pool_t *pool, batch_chunk_t *chunk, int parity)
+{
+    MutexLock(&pool->mutex);
+    for (int i = 0; i < pool->numWorkers; i++)
+    {
+        batch_worker_t *worker = &pool->workers[i];
+        MutexLock(&worker->mutex);
+        worker->head = chunk->count * i / pool->numWorkers;
+        worker->tail = chunk->count * (i + 1) / pool->numWorkers;
+        MutexUnlock(&worker->mutex);
+    }
+    pool->chunk = chunk;
+    pool->parity = parity;
+    pool->active = pool->numWorkers;
+    pool->generation++;
+    CondBroadcast(&pool->start);
+    MutexUnlock(&pool->mutex);
+}
+
+static void BatchWait(batch_pool_t *pool)
+{
+    MutexLock(&pool->mutex);
+    while (pool->active > 0) CondWait(&pool->done, &pool->mutex);
+    MutexUnlock(&pool->mutex);
+}
+
+// Writes the rendered output of a chunk, either in record order, or each worker's output whole
+static void BatchWriteChunk(batch_pool_t *pool, batch_chunk_t *chunk, int parity, output_t *out, bool ordered)
+{
+    if (ordered)
+    {
+        for (size_t i = 0; i < chunk->count; )
+        {
+            // Consecutive records from one worker are usually adjacent in its output
+            batch_record_t *record = &chunk->records[i];
+            size_t length = record->length;
+            for (i++; i < chunk->count && chunk->records[i].worker == record->worker && chunk->records[i].start == record->start + length; i++)
+            {
+                length += chunk->records[i].length;
+            }
+            OutputWrite(out, pool->workers[record->worker].output[parity].buffer + record->start, length);
+        }
+    }
+    for (int i = 0; i < pool->numWorkers; i++)
+    {
+        output_t *workerOutput = &pool->workers[i].output[parity];
+        if (!ordered) OutputWrite(out, workerOutput->buffer, workerOutput->length);
+        if (workerOutput->error) { fprintf(stderr, "ERROR: Out of memory for rendered output.\n"); pool->workers[i].failed = true; }
+        workerOutput->length = 0;
+        workerOutput->error = false;
+    }
+}
+
+// Generates a barcode for every record of the input using a pool of worker threads: records are read in chunks, which are rendered while the previous chunk is written
+static int GenerateBatchThreaded(record_reader_t *reader, output_t *out, const char *fileTemplate, const options_t *options, int numThreads, bool ordered)
+{
+    batch_pool_t *pool = (batch_pool_t *)calloc(1, sizeof(batch_pool_t));
+    batch_chunk_t *chunks = (batch_chunk_t *)calloc(2, sizeof(batch_chunk_t));
+    if (pool == NULL || chunks == NULL) { fprintf(stderr, "ERROR: Out of memory for thread pool.\n"); free(pool); free(chunks); return -1; }
+    pool->options = options;
+    pool->fileTemplate = fileTemplate;
+    MutexInit(&pool->mutex);
+    CondInit(&pool->start);
+    CondInit(&pool->done);
+    for (int i = 0; i < numThreads; i++)
+    {
+        batch_worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        MutexInit(&worker->mutex);
+        OutputInit(&worker->output[0], NULL);
+        OutputInit(&worker->output[1], NULL);
+        if (!ThreadCreate(&worker->thread, BatchWorker, worker)) { fprintf(stderr, "ERROR: Unable to create thread.\n"); MutexDestroy(&worker->mutex); break; }
+        pool->numWorkers++;
+    }
+
+    int current = 0;
+    unsigned long recordNumber = 1;
+    if (pool->numWorkers > 0)
+    {
+        BatchReadChunk(reader, &chunks[current], recordNumber);
+        recordNumber += (unsigned long)chunks[current].count;
+        if (chunks[current].count > 0) BatchStart(pool, &chunks[current], current);
+        while (chunks[current].count > 0)
+        {
+            int next = 1 - current;
+            BatchReadChunk(reader, &chunks[next], recordNumber);
+            recordNumber += (unsigned long)chunks[next].count;
+            BatchWait(pool);
+            if (chunks[next].count > 0) BatchStart(pool, &chunks[next], next);
+            BatchWriteChunk(pool, &chunks[current], current, out, ordered);
+            current = next;
+        }
+    }
+
+    MutexLock(&pool->mutex);
+    pool->quit = true;
+    CondBroadcast(&pool->start);
+    MutexUnlock(&pool->mutex);
+    int result = (pool->numWorkers == numThreads) ? 0 : -1;
+    for (int i = 0; i < pool->numWorkers; i++)
+    {
+        batch_worker_t *worker = &pool->workers[i];
+        ThreadJoin(worker->thread);
+        if (worker->failed) result = -1;
+        MutexDestroy(&worker->mutex);
+        OutputFree(&worker->output[0]);
+        OutputFree(&worker->output[1]);
+        EncoderFree(&worker->encoder);
+    }
+    CondDestroy(&pool->start);
+    CondDestroy(&pool->done);
+    MutexDestroy(&pool->mutex);
+    free(chunks[0].text);
+    free(chunks[1].text);
+    free(chunks);
+    free(pool);
+    return result;
+}
+
+#ifdef __linux__
+// Server (Linux, epoll): renders barcodes for HTTP GET requests on localhost or a Unix domain socket, e.g. /?value=ABC123&output=png&scale=2
+
+#define SERVER_MAX_REQUEST 8192                     // Longest request header (bytes)
+#define SERVER_MAX_VALUE 4096                       // Longest value (after URL decoding)
+#define SERVER_MAX_EVENTS 64
+#define SERVER_CACHE_MAX_BYTES (64 * 1024 * 1024)   // Largest total of cached response bodies
+
+// A rendered response body, cached by the full parameter tuple of the request
+typedef struct render_entry
+{
+    struct render_entry *next;      // Next entry in the hash bucket
+    struct render_entry *older;     // Least-recently used list
+    struct render_entry *newer;
+    uint32_t hash;
+    size_t keyLength;
+    size_t bodyLength;
+    char data[];                    // Key, followed by the body
+} render_entry_t;
+
+// A bounded (least-recently used) cache of rendered response bodies
+typedef struct
+{
+    render_entry_t **buckets;
+    int numBuckets;         // (power of two)
+    int capacity;
+    int count;
+    size_t bytes;
+    render_entry_t *newest;
+    render_entry_t *oldest;
+    unsigned long hits;
+    unsigned long misses;
+} render_cache_t;
+
+static bool RenderCacheInit(render_cache_t *cache, int capacity)
+{
+    memset(cache, 0, sizeof(render_cache_t));
+    cache->capacity = capacity;
+    cache->numBuckets = 1;
+    while (cache->numBuckets < 2 * capacity) cache->numBuckets *= 2;
+    cache->buckets = (render_entry_t **)calloc(cache->numBuckets, sizeof(render_entry_t *));
+    return cache->buckets != NULL;
+}
+
+static void RenderCacheUnlink(render_cache_t *cache, render_entry_t *entry)
+{
+    if (entry->older != NULL) entry->older->newer = entry->newer; else cache->oldest = entry->newer;
+    if (entry->newer != NULL) entry->newer->older = entry->older; else cache->newest = entry->older;
+}
+
+static void RenderCacheLinkNewest(render_cache_t *cache, render_entry_t *entry)
+{
+    entry->older = cache->newest;
+    entry->newer = NULL;
+    if (cache->newest != NULL) cache->newest->newer = entry; else cache->oldest = entry;
+    cache->newest = entry;
+}
+
+static void RenderCacheRemove(render_cache_t *cache, render_entry_t *entry)
+{
+    RenderCacheUnlink(cache, entry);
+    render_entry_t **link = &cache->buckets[entry->hash & (cache->numBuckets - 1)];
+    while (*link != entry) link = &(*link)->next;
+    *link = entry->next;
+    cache->count--;
+    cache->bytes -= entry->bodyLength;
+    free(entry);
+}
+
+static void RenderCacheFree(render_cache_t *cache)
+{
+    while (cache->oldest != NULL) RenderCacheRemove(cache, cache->oldest);
+    free(cache->buckets);
+    memset(cache, 0, sizeof(render_cache_t));
+}
+
+static uint32_t RenderCacheHash(const char *key, size_t keyLength)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < keyLength; i++) hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    return hash;
+}
+
+// Finds the cached body for the key (marking it the most recently used), or NULL if not cached
+static render_entry_t *RenderCacheFind(render_cache_t *cache, uint32_t hash, const char *key, size_t keyLength)
+{
+    for (render_entry_t *entry = cache->buckets[hash & (cache->numBuckets - 1)]; entry != NULL; entry = entry->next)
+    {
+        if (entry->hash == hash && entry->keyLength == keyLength && memcmp(entry->data, key, keyLength) == 0)
+        {
+            if (cache->newest != entry) { RenderCacheUnlink(cache, entry); RenderCacheLinkNewest(cache, entry); }
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Caches a copy of the body, replacing the least-recently used entries to stay within the entry and byte limits
+static void RenderCacheInsert(render_cache_t *cache, uint32_t hash, const char *key, size_t keyLength, const uint8_t *body, size_t bodyLength)
+{
+    if (cache->capacity <= 0 || bodyLength > SERVER_CACHE_MAX_BYTES / 4) return;
+    while (cache->oldest != NULL && (cache->count >= cache->capacity || cache->bytes + bodyLength > SERVER_CACHE_MAX_BYTES)) RenderCacheRemove(cache, cache->oldest);
+    render_entry_t *entry = (render_entry_t *)malloc(sizeof(render_entry_t) + keyLength + bodyLength);
+    if (entry == NULL) return;
+    entry->hash = hash;
+    entry->keyLength = keyLength;
+    entry->bodyLength = bodyLength;
+    memcpy(entry->data, key, keyLength);
+    memcpy(entry->data + keyLength, body, bodyLength);
+    render_entry_t **bucket = &cache->buckets[hash & (cache->numBuckets - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+    RenderCacheLinkNewest(cache, entry);
+    cache->count++;
+    cache->bytes += bodyLength;
+}
+
+typedef struct server_connection
+{
+    struct server_connection *prev;
+    struct server_connection *next;
+    int fd;
+    bool writing;           // Waiting for the socket to be writable
+    bool closing;           // Close once the response is sent
+    size_t requestLength;
+    output_t response;      // Responses not yet sent
+    size_t sent;
+    char request[SERVER_MAX_REQUEST];
+} server_connection_t;
+
+typedef struct
+{
+    const options_t *options;   // Defaults for each request
+    int epoll;
+    int listener;
+    server_connection_t *connections;
+    render_cache_t cache;
+    encoder_t encoder;
+    output_t render;            // Rendered body of a request not found in the cache
+} server_t;
+
+static const char *serverOutputNames[] = { "info", "wide", "narrow", "bmp", "png", "svg", "pdf", "sixel", "tgp", "zpl", "epl" };
+static const char *serverContentTypes[] = { "application/json", "text/plain; charset=utf-8", "text/plain; charset=utf-8", "image/bmp", "image/png", "image/svg+xml", "application/pdf", "application/octet-stream", "application/octet-stream", "application/octet-stream", "application/octet-stream" };
+
+static volatile sig_atomic_t serverQuit = 0;
+
+static void ServerSignal(int signal)
+{
+    (void)signal;
+    serverQuit = 1;
+}
+
+// Decodes a URL query component (percent-encoding, and '+' for space), returns the length, or -1 if invalid or too long
+static int ServerDecode(char *decoded, size_t decodedSize, const char *text, size_t length)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        if (c == '+') c = ' ';
+        else if (c == '%')
+        {
+            int value = 0;
+            for (int j = 1; j <= 2; j++)
+            {
+                char h = (i + j < length) ? text[i + j] : '\0';
+                int digit = (h >= '0' && h <= '9') ? h - '0' : (h >= 'a' && h <= 'f') ? h - 'a' + 10 : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                if (digit < 0) return -1;
+                value = value * 16 + digit;
+            }
+            c = (char)value;
+            i += 2;
+        }
+        if (o + 1 >= decodedSize) return -1;
+        decoded[o++] = c;
+    }
+    decoded[o] = '\0';
+    return (int)o;
+}
+
+// Parses a decimal parameter within the range
+static bool ServerNumber(int *number, const char *text, int minimum, int maximum)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < minimum || value > maximum) return false;
+    *number = (int)value;
+    return true;
+}
+
+static void ServerRespond(server_connection_t *connection, int status, const char *contentType, const void *body, size_t bodyLength, const char *cacheStatus)
+{
+    const char *reason = (status == 200) ? "OK" : (status == 400) ? "Bad Request" : (status == 405) ? "Method Not Allowed" : (status == 431) ? "Request Header Fields Too Large" : "Internal Server Error";
+    OutputPrintf(&connection->response, "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\n", status, reason, contentType, (unsigned long)bodyLength);
+    if (cacheStatus != NULL) OutputPrintf(&connection->response, "X-Cache: %s\r\n", cacheStatus);
+    OutputPrintf(&connection->response, "%s\r\n", connection->closing ? "Connection: close\r\n" : "");
+    OutputWrite(&connection->response, body, bodyLength);
+}
+
+static void ServerError(server_connection_t *connection, int status, const char *message)
+{
+    ServerRespond(connection, status, "text/plain; charset=utf-8", message, strlen(message), NULL);
+}
+
+// Renders the barcode for a request (the header, NUL-terminated), from the cache if possible
+static void ServerRequest(server_t *server, server_connection_t *connection, char *header)
+{
+    // Request line, and whether the connection persists (HTTP/1.1 unless "Connection: close")
+    char *lineEnd = strstr(header, "\r\n");
+    if (lineEnd != NULL) *lineEnd = '\0';
+    char *method = header;
+    char *target = strchr(method, ' ');
+    char *version = (target != NULL) ? strchr(target + 1, ' ') : NULL;
+    if (version == NULL) { connection->closing = true; ServerError(connection, 400, "Malformed request.\n"); return; }
+    *target++ = '\0';
+    *version++ = '\0';
+    if (strcmp(version, "HTTP/1.1")) connection->closing = true;
+    for (char *line = (lineEnd != NULL) ? lineEnd + 2 : NULL; line != NULL && *line != '\0'; )
+    {
+        char *next = strstr(line, "\r\n");
+        if (!strncasecmp(line, "Connection:", 11))
+        {
+            char *token = line + 11;
+            while (*token == ' ') token++;
+            if (!strncasecmp(token, "close", 5)) connection->closing = true;
+            if (!strncasecmp(token, "keep-alive", 10)) connection->closing = false;
+        }
+        line = (next != NULL) ? next + 2 : NULL;
+    }
+    if (strcmp(method, "GET")) { connection->closing = true; ServerError(connection, 405, "Only GET is supported.\n"); return; }
+
+    // Parameters from the query string (any path)
+    options_t options = *server->options;
+    char value[SERVER_MAX_VALUE];
+    int valueLength = -1;
+    char *query = strchr(target, '?');
+    for (char *parameter = (query != NULL) ? query + 1 : NULL; parameter != NULL && *parameter != '\0'; )
+    {
+        char *end = strchr(parameter, '&');
+        if (end != NULL) *end = '\0';
+        char *equals = strchr(parameter, '=');
+        const char *raw = (equals != NULL) ? equals + 1 : "";
+        if (equals != NULL) *equals = '\0';
+        char argument[64];
+        bool valid;
+        if (!strcmp(parameter, "value"))
+        {
+            valueLength = ServerDecode(value, sizeof(value), raw, strlen(raw));
+            valid = valueLength >= 0;
+        }
+        else if (ServerDecode(argument, sizeof(argument), raw, strlen(raw)) < 0) valid = false;
+        else if (!strcmp(parameter, "output"))
+        {
+            valid = false;
+            for (int i = 0; i < (int)(sizeof(serverOutputNames) / sizeof(serverOutputNames[0])); i++)
+            {
+                if (!strcmp(argument, serverOutputNames[i])) { options.outputMode = (output_mode_t)i; valid = true; }
+            }
+        }
+        else if (!strcmp(parameter, "scale")) valid = ServerNumber(&options.scale, argument, 1, 64);
+        else if (!strcmp(parameter, "height")) valid = ServerNumber(&options.height, argument, 1, 4096);
+        else if (!strcmp(parameter, "quiet")) valid = ServerNumber(&options.quiet, argument, 0, 1024);
+        else if (!strcmp(parameter, "code"))
+        {
+            valid = true;
+            if (!strcmp(argument, "auto")) options.fixedCode = BARCODE_CODE_NONE;
+            else if (!strcmp(argument, "a")) options.fixedCode = BARCODE_CODE_A;
+            else if (!strcmp(argument, "b")) options.fixedCode = BARCODE_CODE_B;
+            else if (!strcmp(argument, "c")) options.fixedCode = BARCODE_CODE_C;
+            else if (!strcmp(argument, "optimal")) options.fixedCode = BARCODE_CODE_OPTIMAL;
+            else valid = false;
+        }
+        else if (!strcmp(parameter, "rotate")) valid = RotationParse(&options.rotation, argument);
+        else if (!strcmp(parameter, "invert"))
+        {
+            valid = true;
+            if (!strcmp(argument, "") || !strcmp(argument, "1") || !strcmp(argument, "true")) options.invert = true;
+            else if (!strcmp(argument, "0") || !strcmp(argument, "false")) options.invert = false;
+            else valid = false;
+        }
+        else valid = false;
+        if (!valid) { ServerError(connection, 400, "Invalid parameter.\n"); return; }
+        parameter = (end != NULL) ? end + 1 : NULL;
+    }
+    if (valueLength < 0) { ServerError(connection, 400, "Value not specified.\n"); return; }
+    if (!RotationSupported(options.rotation, options.outputMode)) { ServerError(connection, 400, "Rotation not supported for the output.\n"); return; }
+    OptionsDefaults(&options);
+
+    // The cache key is every parameter that affects the rendering
+    char key[64 + SERVER_MAX_VALUE];
+    int keyLength = sprintf(key, "%d %d %d %d %d %d %d ", (int)options.outputMode, options.scale, options.height, options.quiet, (int)options.fixedCode, options.invert ? 1 : 0, (int)options.rotation);
+    memcpy(key + keyLength, value, valueLength);
+    keyLength += valueLength;
+    uint32_t hash = RenderCacheHash(key, keyLength);
+    const char *contentType = serverContentTypes[options.outputMode];
+    render_entry_t *entry = RenderCacheFind(&server->cache, hash, key, keyLength);
+    if (entry != NULL)
+    {
+        server->cache.hits++;
+        ServerRespond(connection, 200, contentType, entry->data + entry->keyLength, entry->bodyLength, "hit");
+        return;
+    }
+    server->cache.misses++;
+
+    server->render.length = 0;
+    if (!GenerateBarcode(&server->render, &options, value, valueLength, &server->encoder)) { ServerError(connection, 400, "Value cannot be encoded.\n"); return; }
+    if (server->render.error) { server->render.error = false; ServerError(connection, 500, "Out of memory.\n"); return; }
+    RenderCacheInsert(&server->cache, hash, key, keyLength, server->render.buffer, server->render.length);
+    ServerRespond(connection, 200, contentType, server->render.buffer, server->render.length, "miss");
+}
+
+static void ServerClose(server_t *server, server_connection_t *connection)
+{
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    if (connection->prev != NULL) connection->prev->next = connection->next; else server->connections = connection->next;
+    if (connection->next != NULL) connection->next->prev = connection->prev;
+    OutputFree(&connection->response);
+    free(connection);
+}
+
+// Sends as much of the pending responses as the socket accepts, returns false if the connection is to be closed
+static bool ServerSend(server_t *server, server_connection_t *connection)
+{
+    while (connection->sent < connection->response.length)
+    {
+        STATS(double start = server->options->stats ? OutputTime() : 0);
+        ssize_t count = send(connection->fd, connection->response.buffer + connection->sent, connection->response.length - connection->sent, MSG_NOSIGNAL);
+        STATS(if (server->options->stats) { server->encoder.stats.writeTime += OutputTime() - start; if (count > 0) server->encoder.stats.bytesWritten += (uint64_t)count; });
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // Wait until writable (and stop reading requests until then)
+            if (!connection->writing)
+            {
+                struct epoll_event event = { .events = EPOLLOUT, .data.ptr = connection };
+                epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->fd, &event);
+                connection->writing = true;
+            }
+            return true;
+        }
+        if (count <= 0) return false;
+        connection->sent += (size_t)count;
+    }
+    connection->response.length = 0;
+    connection->sent = 0;
+    if (connection->closing) return false;
+    if (connection->writing)
+    {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        epoll_ctl(server->epoll, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->writing = false;
+    }
+    return true;
+}
+
+// Reads and responds to each complete request, returns false if the connection is to be closed
+static bool ServerReceive(server_t *server, server_connection_t *connection)
+{
+    for (;;)
+    {
+        ssize_t count = recv(connection->fd, connection->request + connection->requestLength, SERVER_MAX_REQUEST - 1 - connection->requestLength, 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (count <= 0) return false;
+        connection->requestLength += (size_t)count;
+
+        // Respond to each complete request (pipelined requests are answered in order)
+        size_t start = 0;
+        for (;;)
+        {
+            connection->request[connection->requestLength] = '\0';
+            char *end = strstr(connection->request + start, "\r\n\r\n");
+            if (end == NULL) break;
+            end[2] = '\0';
+            ServerRequest(server, connection, connection->request + start);
+            start = (size_t)(end + 4 - connection->request);
+            if (connection->closing) return ServerSend(server, connection);
+        }
+        memmove(connection->request, connection->request + start, connection->requestLength - start);
+        connection->requestLength -= start;
+        if (connection->requestLength >= SERVER_MAX_REQUEST - 1)
+        {
+            connection->closing = true;
+            ServerError(connection, 431, "Request too large.\n");
+            return ServerSend(server, connection);
+        }
+        if (connection->response.length > 0 && !ServerSend(server, connection)) return false;
+        if (connection->writing) break;
+    }
+    return true;
+}
+
+// Listens on a localhost TCP port (if a number) or a Unix domain socket path, returns the socket or -1
+static int ServerListen(const char *address)
+{
+    char *end;
+    long port = strtol(address, &end, 10);
+    int fd;
+    if (end != address && *end == '\0')
+    {
+        if (port <= 0 || port > 65535) { fprintf(stderr, "ERROR: Invalid port: %s\n", address); return -1; }
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) { close(fd); fd = -1; }
+    }
+    else
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(addr.sun_path)) { fprintf(stderr, "ERROR: Socket path too long: %s\n", address); return -1; }
+        strcpy(addr.sun_path, address);
+        // Replace a stale socket (but nothing else)
+        struct stat st;
+        if (stat(address, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) { close(fd); fd = -1; }
+    }
+    if (fd >= 0 && (listen(fd, SOMAXCONN) < 0 || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)) { close(fd); fd = -1; }
+    if (fd < 0) fprintf(stderr, "ERROR: Unable to listen on: %s (%s)\n", address, strerror(errno));
+    return fd;
+}
+
+// Closes the connections, event loop and listener (removing a Unix socket), and frees the server, after it stops or fails to start
+static void ServerFree(server_t *server, const char *address)
+{
+    while (server->connections != NULL) ServerClose(server, server->connections);
+    if (server->epoll >= 0) close(server->epoll);
+    if (server->listener >= 0)
+    {
+        close(server->listener);
+        if (strtol(address, NULL, 10) <= 0) unlink(address);
+    }
+    RenderCacheFree(&server->cache);
+    EncoderFree(&server->encoder);
+    OutputFree(&server->render);
+}
+
+// Serves requests until interrupted (SIGINT/SIGTERM)
+static int Serve(const char *address, const options_t *options, int cacheEntries)
+{
+    server_t server;
+    memset(&server, 0, sizeof(server));
+    server.options = options;
+    server.epoll = -1;
+    server.listener = -1;
+    EncoderInit(&server.encoder);
+    OutputInit(&server.render, NULL);
+    if (!RenderCacheInit(&server.cache, cacheEntries)) { fprintf(stderr, "ERROR: Out of memory for the render cache.\n"); ServerFree(&server, address); return -1; }
+    server.listener = ServerListen(address);
+    if (server.listener < 0) { ServerFree(&server, address); return -1; }
+    server.epoll = epoll_create1(0);
+    struct epoll_event listenEvent = { .events = EPOLLIN, .data.ptr = NULL };
+    if (server.epoll < 0 || epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.listener, &listenEvent) < 0) { fprintf(stderr, "ERROR: Unable to create event loop.\n"); ServerFree(&server, address); return -1; }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = ServerSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    fprintf(stderr, "Serving on: %s\n", address);
+
+    while (!serverQuit)
+    {
+        struct epoll_event events[SERVER_MAX_EVENTS];
+        int timeout = (options->stats && options->statsInterval > 0) ? (int)(options->statsInterval * 1000) : -1;
+        int count = epoll_wait(server.epoll, events, SERVER_MAX_EVENTS, timeout);
+        STATS(StatsPeriodic(options, &server.encoder, NULL));
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) { fprintf(stderr, "ERROR: Event loop failed (%s)\n", strerror(errno)); break; }
+        for (int i = 0; i < count; i++)
+        {
+            server_connection_t *connection = (server_connection_t *)events[i].data.ptr;
+            if (connection == NULL)
+            {
+                // Accept every pending connection
+                int fd;
+                while ((fd = accept(server.listener, NULL, NULL)) >= 0)
+                {
+                    connection = (server_connection_t *)malloc(sizeof(server_connection_t));
+                    if (connection == NULL || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) { free(connection); close(fd); continue; }
+                    memset(connection, 0, offsetof(server_connection_t, request));
+                    connection->fd = fd;
+                    OutputInit(&connection->response, NULL);
+                    struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+                    if (epoll_ctl(server.epoll, EPOLL_CTL_ADD, fd, &event) < 0) { free(connection); close(fd); continue; }
+                    connection->next = server.connections;
+                    if (server.connections != NULL) server.connections->prev = connection;
+                    server.connections = connection;
+                }
+                continue;
+            }
+            bool open = true;
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) open = false;
+            if (open && (events[i].events & EPOLLOUT)) open = ServerSend(&server, connection);
+            if (open && !connection->writing && (events[i].events & EPOLLIN)) open = ServerReceive(&server, connection);
+            if (!open) ServerClose(&server, connection);
+        }
+    }
+
+    fprintf(stderr, "Render cache: %lu hits, %lu misses\n", server.cache.hits, server.cache.misses);
+    ServerFree(&server, address);
+    return 0;
+}
+#endif
+
+
+int main(int argc, char *argv[])
+{
+    FILE *ofp = stdout;
+    const char *value = NULL;
+    bool help = false;
+    bool address = false;
+    bool batch = false;
+    bool sequenced = false;
+    sequence_t sequence = {0};
+    const char *inputFilename = NULL;
+    const char *fileTemplate = NULL;
+    const char *serveAddress = NULL;
+    int serveCache = 1024;
+    char delimiter = '\n';
+    char separator = '\0';
+    int column = 0;
+    bool header = false;
+    int numThreads = 1;
+    bool ordered = true;
+    sheet_t sheet = {0};
+    options_t options = {0};
+    options.outputMode = OUTPUT_TEXT_NARROW;
+    options.quiet = BARCODE_QUIET_STANDARD;
+    options.scale = -1;
+    options.height = -1;
+    options.moduleSize = DEFAULT_MODULE_SIZE;
+    options.invert = false;
+    options.fixedCode = BARCODE_CODE_NONE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--help")) { help = true; }
+        else if (!strcmp(argv[i], "--height")) { options.height = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--scale")) { options.scale = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--module"))
+        {
+            // Module size in millimeters, or points with a "pt" suffix
+            char *end;
+            options.moduleSize = strtod(argv[++i], &end);
+            if (!strcmp(end, "pt")) options.moduleSize *= 25.4 / 72.0;
+            else if (*end != '\0' && strcmp(end, "mm")) options.moduleSize = -1;
+            if (options.moduleSize <= 0) { fprintf(stderr, "ERROR: Invalid module size: %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--quiet")) { options.quiet = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--invert")) { options.invert = !options.invert; }
+        else if (!strcmp(argv[i], "--rotate"))
+        {
+            if (!RotationParse(&options.rotation, argv[++i])) { fprintf(stderr, "ERROR: Invalid rotation (0, 90, 180 or 270 degrees): %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--file"))
+        {
+            ofp = fopen(argv[++i], "wb");
+            if (ofp == NULL) { fprintf(stderr, "ERROR: Unable to open output filename: %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--file-template")) { fileTemplate = argv[++i]; }
+        else if (!strcmp(argv[i], "--sequence"))
+        {
+            if (!SequenceParse(&sequence, argv[++i])) { fprintf(stderr, "ERROR: Invalid sequence (start:end[:step]): %s\n", argv[i]); return -1; }
+            sequenced = true;
+        }
+        else if (!strcmp(argv[i], "--batch")) { batch = true; }
+        else if (!strcmp(argv[i], "--input")) { inputFilename = argv[++i]; batch = true; }
+        else if (!strcmp(argv[i], "--null")) { delimiter = '\0'; }
+        else if (!strcmp(argv[i], "--csv")) { separator = ','; }
+        else if (!strcmp(argv[i], "--tsv")) { separator = '\t'; }
+        else if (!strcmp(argv[i], "--column"))
+        {
+            column = atoi(argv[++i]);
+            if (column <= 0) { fprintf(stderr, "ERROR: Invalid column (first is 1): %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--header")) { header = true; }
+        else if (!strcmp(argv[i], "--sheet"))
+        {
+            if (!SheetPair(argv[++i], &sheet.columns, &sheet.rows, false, 1) || sheet.columns * sheet.rows > 65536) { fprintf(stderr, "ERROR: Invalid sheet grid (columns x rows): %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--gutter"))
+        {
+            if (!SheetPair(argv[++i], &sheet.gutterX, &sheet.gutterY, true, 0)) { fprintf(stderr, "ERROR: Invalid sheet gutter (pixels, or horizontal x vertical): %s\n", argv[i]); return -1; }
+        }
+        else if (!strcmp(argv[i], "--label")) { sheet.label = true; }
+        else if (!strcmp(argv[i], "--threads")) { numThreads = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--unordered")) { ordered = false; }
+        else if (!strcmp(argv[i], "--output:info")) { options.outputMode = OUTPUT_INFO; }
+        else if (!strcmp(argv[i], "--output:wide")) { options.outputMode = OUTPUT_TEXT_WIDE; }
+        else if (!strcmp(argv[i], "--output:narrow")) { options.outputMode = OUTPUT_TEXT_NARROW; }
+        else if (!strcmp(argv[i], "--output:bmp")) { options.outputMode = OUTPUT_IMAGE_BITMAP; }
+        else if (!strcmp(argv[i], "--output:png")) { options.outputMode = OUTPUT_PNG; }
+        else if (!strcmp(argv[i], "--output:svg")) { options.outputMode = OUTPUT_SVG; }
+        else if (!strcmp(argv[i], "--output:pdf")) { options.outputMode = OUTPUT_PDF; }
+        else if (!strcmp(argv[i], "--output:sixel")) { options.outputMode = OUTPUT_SIXEL; }
+        else if (!strcmp(argv[i], "--output:tgp")) { options.outputMode = OUTPUT_TGP; }
+        else if (!strcmp(argv[i], "--output:zpl")) { options.outputMode = OUTPUT_ZPL; }
+        else if (!strcmp(argv[i], "--output:epl")) { options.outputMode = OUTPUT_EPL; }
+        else if (!strcmp(argv[i], "--code:auto")) { options.fixedCode = BARCODE_CODE_NONE; }
+        else if (!strcmp(argv[i], "--code:a")) { options.fixedCode = BARCODE_CODE_A; }
+        else if (!strcmp(argv[i], "--code:b")) { options.fixedCode = BARCODE_CODE_B; }
+        else if (!strcmp(argv[i], "--code:c")) { options.fixedCode = BARCODE_CODE_C; }
+        else if (!strcmp(argv[i], "--code:optimal")) { options.fixedCode = BARCODE_CODE_OPTIMAL; }
+        else if (!strcmp(argv[i], "--verify")) { options.verify = true; }
+        else if (!strcmp(argv[i], "--serve")) { serveAddress = argv[++i]; }
+        else if (!strcmp(argv[i], "--serve-cache")) { serveCache = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--stats")) { options.stats = true; }
+        else if (!strcmp(argv[i], "--stats-interval")) { options.stats = true; options.statsInterval = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "--prefix-cache")) { options.prefixCache = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "--address")) { address = true; }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "ERROR: Unrecognized parameter: %s\n", argv[i]); 
+            help = true;
+            break;
+        }
+        else if (value == NULL)
+        {
+            value = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unrecognized positional parameter: %s\n", argv[i]); 
+            help = true;
+            break;
+        }
+    }
+
+    // An output filename template or a sheet generates a batch from the standard input, unless generating a sequence
+    if ((fileTemplate != NULL || sheet.columns > 0) && !sequenced) batch = true;
+
+    if (serveAddress != NULL && (batch || sequenced || address || value != NULL))
+    {
+        fprintf(stderr, "ERROR: The server takes each value from its requests.\n"); 
+        help = true;
+    }
+    else if (sequenced && (batch || address || sheet.columns > 0))
+    {
+        fprintf(stderr, "ERROR: A sequence cannot be generated in batch, sheet or address mode.\n"); 
+        help = true;
+    }
+    else if (batch && (value != NULL || address))
+    {
+        fprintf(stderr, "ERROR: A value cannot be specified in batch mode.\n"); 
+        help = true;
+    }
+    else if (sheet.columns > 0 && options.outputMode != OUTPUT_IMAGE_BITMAP && options.outputMode != OUTPUT_PNG)
+    {
+        fprintf(stderr, "ERROR: A sheet is output as a bitmap image (--output:bmp or --output:png).\n"); 
+        help = true;
+    }
+    else if (sheet.columns > 0 && options.rotation != BARCODE_ROTATE_0)
+    {
+        fprintf(stderr, "ERROR: The barcodes of a sheet cannot be rotated.\n"); 
+        help = true;
+    }
+    else if (!RotationSupported(options.rotation, options.outputMode))
+    {
+        fprintf(stderr, "ERROR: Ladder orientation (--rotate 90|270) is only for --output:bmp or --output:png, and the information output cannot be rotated.\n"); 
+        help = true;
+    }
+    else if (!batch && serveAddress == NULL && value == NULL)
+    {
+        fprintf(stderr, "ERROR: Value not specified.\n"); 
+        help = true;
+    }
+
+    if (help)
+    {
+        fprintf(stderr, "USAGE: barcode [--height 5] [--scale 1] [--quiet 10] [--invert] [--rotate 0|90|180|270] [--output:<wide|narrow|bmp|png|svg|pdf|sixel|tgp|zpl|epl>] [--module 0.33mm|1pt] [--code:<auto|a|b|c|optimal>] [--verify] [--file filename] <value>\n"); 
+        fprintf(stderr, "       (--code:optimal is the narrowest coding for values up to %d characters, longer values are coded automatically)\n", BARCODE_OPTIMAL_MAX_LENGTH); 
+        fprintf(stderr, "       barcode [options...] <--batch|--input filename> [--null] [--csv|--tsv] [--column 1] [--header] [--threads 1] [--unordered] [--prefix-cache 256] [--stats] [--stats-interval 10] [--file filename|--file-template name-%%06n.bmp]\n"); 
+        fprintf(stderr, "       barcode [options...] --output:<bmp|png> --sheet 4x10 [--gutter 20[x20]] [--label] [--batch|--input filename] [--file filename|--file-template page-%%03n.png]\n"); 
+        fprintf(stderr, "       barcode [options...] --sequence start:end[:step] [--file filename|--file-template name-%%06n.bmp] <value-template, e.g. LOT42-%%06n>\n"); 
+        fprintf(stderr, "       barcode [options...] --serve <port|socket-path> [--serve-cache 1024]   (requests: GET /?value=...&output=png&scale=2&height=30&quiet=10&code=auto&invert=1&rotate=90)\n"); 
+        return -1;
+    }
+
+#ifdef NO_STATS
+    if (options.stats) { fprintf(stderr, "ERROR: Statistics are not available (built with NO_STATS).\n"); return -1; }
+#else
+    if (options.stats)
+    {
+        // The output is already buffered, so unbuffered files time the writes themselves
+        setvbuf(ofp, NULL, _IONBF, 0);
+        statsStart = OutputTime();
+        statsNext = statsStart + options.statsInterval;
+    }
+#endif
+
+    if (serveAddress != NULL)
+    {
+#ifdef __linux__
+        int result = Serve(serveAddress, &options, serveCache);
+        STATS(if (options.stats) StatsPrint(stderr, &statsTotal));
+        return result;
+#else
+        fprintf(stderr, "ERROR: Server mode is only available on Linux.\n");
+        return -1;
+#endif
+    }
+
+    if (address) 
+    {
+        // Special decimal conversion for 6-byte Bluetooth hex addresses given in the format: "01:23:45:67:89:AB", ignoring top two bits (signify private address), output is 128 pixel width.
+        if (strlen(value) != 17 || value[2] != ':' || value[5] != ':' || value[8] != ':' || value[11] != ':' || value[14] != ':')  { fprintf(stderr, "ERROR: Address format error: %s\n", value); return -1; }
+        static char buffer[14 + 1];
+        uint64_t address = ((uint64_t)strtoul(value + 0, NULL, 16) << 40) | ((uint64_t)strtoul(value + 3, NULL, 16) << 32) | ((uint64_t)strtoul(value + 6, NULL, 16) << 24) | ((uint64_t)strtoul(value + 9, NULL, 16) << 16) | ((uint64_t)strtoul(value + 12, NULL, 16) << 8) | ((uint64_t)strtoul(value + 15, NULL, 16));
+        address &= (uint64_t)0x003fffffffffffull;   // Mask off top two bits (46-bit number)
+        sprintf(buffer, "%014"PRIu64"", address);   // Max value is 70368744177663 (14 digits)
+        printf("Address: %02x:%02x:%02x:%02x:%02x:%02x\n", (int)((address >> (5*8)) & 0xff),  (int)((address >> (4*8)) & 0xff), (int)((address >> (3*8)) & 0xff), (int)((address >> (2*8)) & 0xff), (int)((address >> (1*8)) & 0xff), (int)((address) & 0xff));
+        printf("Decimal: %s\n", buffer);
+        value = buffer;
+        options.quiet = 8;
+    }
+
+    OptionsDefaults(&options);
+    options.resume = sequenced || options.prefixCache > 0;
+
+#ifdef _WIN32
+    if (options.outputMode == OUTPUT_TEXT_WIDE || options.outputMode == OUTPUT_TEXT_NARROW) SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    int result = 0;
+    output_t out;
+    OutputInit(&out, ofp);
+    out.timed = options.stats;
+    if (sequenced)
+    {
+        result = GenerateSequence(&sequence, value, &out, fileTemplate, &options);
+    }
+    else if (batch)
+    {
+        FILE *ifp = stdin;
+        if (inputFilename != NULL)
+        {
+            ifp = fopen(inputFilename, "rb");
+            if (ifp == NULL) { fprintf(stderr, "ERROR: Unable to open input filename: %s\n", inputFilename); return -1; }
+        }
+        record_reader_t reader;
+        if (!RecordReaderInit(&reader, ifp, delimiter)) { fprintf(stderr, "ERROR: Out of memory for input buffer.\n"); return -1; }
+
+        // The value from a column of each record (CSV by default), optionally after a header record
+        if (separator == '\0' && column > 0) separator = ',';
+        reader.separator = separator;
+        reader.quoted = (separator == ',');
+        reader.column = (column > 0) ? column - 1 : 0;
+        const char *record;
+        size_t recordLength;
+        if (header) RecordReaderNext(&reader, &record, &recordLength);
+
+        // Zero threads uses one per processor
+        if (numThreads <= 0) numThreads = ProcessorCount();
+        if (numThreads > BATCH_MAX_THREADS) numThreads = BATCH_MAX_THREADS;
+        if (sheet.columns > 0)
+        {
+            result = GenerateSheet(&reader, &out, fileTemplate, &options, &sheet);
+        }
+        else if (numThreads > 1)
+        {
+            result = GenerateBatchThreaded(&reader, &out, fileTemplate, &options, numThreads, ordered);
+        }
+        else
+        {
+            result = GenerateBatch(&reader, &out, fileTemplate, &options);
+        }
+
+        RecordReaderClose(&reader);
+        if (ifp != stdin) fclose(ifp);
+    }
+    else
+    {
+        encoder_t encoder;
+        EncoderInit(&encoder);
+        if (!GenerateBarcode(&out, &options, value, strlen(value), &encoder)) result = -1;
+        EncoderFree(&encoder);
+    }
+    OutputFree(&out);
+    STATS(if (options.stats) { StatsOutput(&statsTotal, &out); StatsPrint(stderr, &statsTotal); });
+    if (options.prefixCache > 0) fprintf(stderr, "Prefix cache: %lu hits, %lu misses\n", prefixCacheHits, prefixCacheMisses);
+
+    if (ofp != stdout) fclose(ofp);
+    return result;
+}
@@ -0,0 +1,1162 @@
+// Barcode - Output renderers for the demonstration program
+// Dan Jackson, 2019
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS // This is an example program only
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "barcode.h"
+#include "output.h"
+
+double OutputTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Writes to the file, counting (and optionally timing) the bytes written
+static void OutputFileWrite(output_t *out, const void *data, size_t size)
+{
+#ifndef NO_STATS
+    double start = out->timed ? OutputTime() : 0;
+#endif
+    fwrite(data, 1, size, out->fp);
+    out->written += size;
+#ifndef NO_STATS
+    if (out->timed) out->writeTime += OutputTime() - start;
+#endif
+}
+
+void OutputInit(output_t *out, FILE *fp)
+{
+    memset(out, 0, sizeof(output_t));
+    out->fp = fp;
+}
+
+void OutputFlush(output_t *out)
+{
+    if (out->fp != NULL && out->length > 0)
+    {
+        OutputFileWrite(out, out->buffer, out->length);
+        out->length = 0;
+    }
+}
+
+void OutputFree(output_t *out)
+{
+    OutputFlush(out);
+    free(out->buffer);
+    out->buffer = NULL;
+    out->capacity = 0;
+    out->length = 0;
+}
+
+// Returns space for the specified number of bytes at the end of the output (flushing or growing as required), or NULL if unavailable (larger than the file buffer, or out of memory)
+uint8_t *OutputAppend(output_t *out, size_t size)
+{
+    if (out->length + size > out->capacity)
+    {
+        OutputFlush(out);
+        size_t capacity = out->capacity > 0 ? out->capacity : OUTPUT_FILE_BUFFER;
+        while (capacity < out->length + size) capacity *= 2;
+        if (out->fp != NULL && capacity > OUTPUT_FILE_BUFFER) return NULL;
+        if (capacity > out->capacity)
+        {
+            uint8_t *buffer = (uint8_t *)realloc(out->buffer, capacity);
+            if (buffer == NULL) { out->error = true; return NULL; }
+            out->allocations++;
+            out->buffer = buffer;
+            out->capacity = capacity;
+        }
+    }
+    uint8_t *p = out->buffer + out->length;
+    out->length += size;
+    return p;
+}
+
+void OutputWrite(output_t *out, const void *data, size_t size)
+{
+    uint8_t *p = OutputAppend(out, size);
+    if (p != NULL)
+    {
+        memcpy(p, data, size);
+    }
+    else if (out->fp != NULL && !out->error)
+    {
+        OutputFileWrite(out, data, size);   // Larger than the file buffer (already flushed)
+    }
+}
+
+void OutputPrintf(output_t *out, const char *format, ...)
+{
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int count = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (count < 0) return;
+    if ((size_t)count < sizeof(line))
+    {
+        OutputWrite(out, line, (size_t)count);
+        return;
+    }
+    // Longer output is formatted again, directly in to the output buffer
+    char *p = (char *)OutputAppend(out, (size_t)count + 1);
+    if (p == NULL) return;
+    va_start(args, format);
+    vsnprintf(p, (size_t)count + 1, format, args);
+    va_end(args);
+    out->length--;      // Terminator not included
+}
+
+// Endian-independent short/long write
+static uint8_t *putshort(uint8_t *p, uint16_t v) { p[0] = (uint8_t)((v >> 0) & 0xff); p[1] = (uint8_t)((v >> 8) & 0xff); return p + 2; }
+static uint8_t *putlong(uint8_t *p, uint32_t v) { p[0] = (uint8_t)((v >> 0) & 0xff); p[1] = (uint8_t)((v >> 8) & 0xff); p[2] = (uint8_t)((v >> 16) & 0xff); p[3] = (uint8_t)((v >> 24) & 0xff); return p + 4; }
+
+void OutputBarcodeInfo(output_t *out, uint8_t *bitmap, size_t length, const char *input, size_t inputLength)
+{
+    size_t size = ((length + 7) >> 3);
+    
+    OutputPrintf(out, "{\n");
+
+    OutputPrintf(out, "    \"value\": \"");
+    for (size_t i = 0; i < inputLength; i++)
+    {
+        char c = (char)input[i];
+        char escaped[5] = {0};
+        if (c < 0x20 || c >= 127)
+        {
+            sprintf(escaped, "\\x%02x", (unsigned int)(c & 0xff));
+        }
+        else if (c == '\\')
+        {
+            sprintf(escaped, "\\\\");
+        }
+        else if (c == '\"')
+        {
+            sprintf(escaped, "\\\"");
+        }
+        else
+        {
+            sprintf(escaped, "%c", c);
+        }
+        OutputPrintf(out, "%s", escaped);
+    }
+    OutputPrintf(out, "\",\n");
+
+    OutputPrintf(out, "    \"width\": %u,\n", (unsigned int)length);
+
+    OutputPrintf(out, "    \"bytes\": %u,\n", (unsigned int)size);
+
+    OutputPrintf(out, "    \"data\": [");
+    for (size_t i = 0; i < size; i++)
+    {
+        OutputPrintf(out, "%s0x%02x", i > 0 ? ", " : "", bitmap[i]);
+    }
+    OutputPrintf(out, "]\n");
+
+    OutputPrintf(out, "}\n");
+}
+
+// UTF-8 glyphs for the text renderers, indexed by a pair of pixels (left in bit 1, right in bit 0; 1=white)
+typedef struct { char text[4]; uint8_t length; } text_glyph_t;
+static const text_glyph_t textGlyphs[4] =
+{
+    { "█", 3 },     // '\u{2588}' block
+    { "▌", 3 },     // '\u{258C}' left
+    { "▐", 3 },     // '\u{2590}' right
+    { " ", 1 },     // '\u{0020}' space
+};
+
+// Builds one line of the text barcode (each row is the same), returns the length including the newline
+static size_t TextLine(char *line, bool narrow, uint8_t *bitmap, size_t length, int scale, bool invert)
+{
+    char *p = line;
+    size_t columns = (size_t)scale * length;
+    if (narrow)
+    {
+        // Two pixels per character
+        for (size_t i = 0; i < columns; i += 2)
+        {
+            bool bit0 = BARCODE_BIT(bitmap, i / scale);
+            bool bit1 = ((i + 1) / scale) < length ? BARCODE_BIT(bitmap, (i + 1) / scale) : !invert;
+            const text_glyph_t *glyph = &textGlyphs[((bit0 ? 2 : 0) + (bit1 ? 1 : 0)) ^ (invert ? 0x3 : 0x0)];
+            memcpy(p, glyph->text, 3);
+            p += glyph->length;
+        }
+    }
+    else
+    {
+        // One pixel per character, repeated for the scale
+        for (size_t x = 0; x < length; x++)
+        {
+            const text_glyph_t *glyph = &textGlyphs[(BARCODE_BIT(bitmap, x) ^ invert) ? 3 : 0];
+            for (int s = 0; s < scale; s++)
+            {
+                memcpy(p, glyph->text, 3);
+                p += glyph->length;
+            }
+        }
+    }
+    *p++ = '\n';
+    return (size_t)(p - line);
+}
+
+// The line is built once, then repeated for the height: in the output buffer where it fits, otherwise written from a separate line buffer
+static void TextLines(output_t *out, bool narrow, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    size_t columns = (size_t)scale * length;
+    size_t maxLine = (narrow ? (columns + 1) / 2 : columns) * 3 + 1 + 3;   // (glyphs are copied as a whole word)
+    if (height <= 0 || scale <= 0) return;
+
+    char *text = (char *)OutputAppend(out, maxLine * height);
+    if (text != NULL)
+    {
+        size_t lineLength = TextLine(text, narrow, bitmap, length, scale, invert);
+        for (int y = 1; y < height; y++)
+        {
+            memcpy(text + (size_t)y * lineLength, text, lineLength);
+        }
+        out->length -= (maxLine - lineLength) * height;
+        return;
+    }
+    if (out->error) return;
+
+    char *line = (char *)malloc(maxLine);
+    out->allocations++;
+    if (line == NULL) { fprintf(stderr, "ERROR: Out of memory for text line.\n"); return; }
+    size_t lineLength = TextLine(line, narrow, bitmap, length, scale, invert);
+    for (int y = 0; y < height; y++)
+    {
+        OutputWrite(out, line, lineLength);
+    }
+    free(line);
+}
+
+void OutputBarcodeTextWide(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    TextLines(out, false, bitmap, length, scale, height, invert);
+}
+
+void OutputBarcodeTextNarrow(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    TextLines(out, true, bitmap, length, scale, height, invert);
+}
+
+
+#define BMP_HEADERSIZE 54
+#define BMP_PAL_SIZE (2 * 4)
+
+// Sets a range of pixels in a 1-bit-per-pixel row (most significant bit first)
+static void RowSetBits(uint8_t *row, size_t start, size_t count)
+{
+    size_t end = start + count;
+    if (count == 0) return;
+    uint8_t *first = row + (start >> 3);
+    uint8_t *last = row + ((end - 1) >> 3);
+    uint8_t firstMask = (uint8_t)(0xff >> (start & 7));
+    uint8_t lastMask = (uint8_t)(0xff << (7 - ((end - 1) & 7)));
+    if (first == last)
+    {
+        *first |= firstMask & lastMask;
+        return;
+    }
+    *first |= firstMask;
+    if (last > first + 1) memset(first + 1, 0xff, (size_t)(last - first - 1));
+    *last |= lastMask;
+}
+
+// Packs a single scanline of the 1-bit image (padding bits are zero), filling whole runs of white bars
+static void ImageBitmapScanline(uint8_t *row, int span, uint8_t *bitmap, size_t length, int scale, bool invert)
+{
+    memset(row, 0x00, span);
+    for (size_t i = 0; i < length; )
+    {
+        bool bit = BARCODE_BIT(bitmap, i) ^ invert;
+        size_t start = i;
+        while (++i < length && (BARCODE_BIT(bitmap, i) ^ invert) == bit) { }
+        if (bit) RowSetBits(row, start * scale, (i - start) * scale);
+    }
+}
+
+// Fills the file and bitmap information headers and palette, returns the total file size
+static size_t ImageBitmapHeader(uint8_t *header, int width, int height, int span, bool topDown)
+{
+    int bufferSize = span * height;
+    uint8_t *p = header;
+    *p++ = 'B'; *p++ = 'M';          // bfType
+    p = putlong(p, bufferSize + BMP_HEADERSIZE + BMP_PAL_SIZE); // bfSize
+    p = putshort(p, 0);              // bfReserved1
+    p = putshort(p, 0);              // bfReserved2
+    p = putlong(p, BMP_HEADERSIZE + BMP_PAL_SIZE); // bfOffBits
+    p = putlong(p, 40);              // biSize
+    p = putlong(p, width);           // biWidth
+    p = putlong(p, topDown ? -height : height); // biHeight (negative for top-down)
+    p = putshort(p, 1);              // biPlanes
+    p = putshort(p, 1);              // biBitCount
+    p = putlong(p, 0);               // biCompression
+    p = putlong(p, bufferSize);      // biSizeImage
+    p = putlong(p, 0);               // biXPelsPerMeter 3780
+    p = putlong(p, 0);               // biYPelsPerMeter 3780
+    p = putlong(p, 0);               // biClrUsed
+    p = putlong(p, 0);               // biClrImportant
+    // Palette Entry 0 - black
+    *p++ = 0x00; *p++ = 0x00; *p++ = 0x00; *p++ = 0x00;
+    // Palette Entry 1 - white
+    *p++ = 0xff; *p++ = 0xff; *p++ = 0xff; *p++ = 0x00;
+    return (size_t)bufferSize + BMP_HEADERSIZE + BMP_PAL_SIZE;
+}
+
+// Writes the BMP image to a memory buffer, returns the size of the image (nothing is written if the buffer is too small, e.g. NULL to query the size)
+size_t OutputBarcodeImageBitmapMemory(uint8_t *buffer, size_t bufferSize, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    int width = (int)(length * scale);
+    int span = ((width + 31) / 32) * 4;
+    uint8_t header[BMP_HEADERSIZE + BMP_PAL_SIZE];
+    size_t size = ImageBitmapHeader(header, width, height, span, false);
+    if (buffer == NULL || bufferSize < size) return size;
+
+    // The scanline is packed once, and every row is a copy
+    memcpy(buffer, header, sizeof(header));
+    uint8_t *row = buffer + sizeof(header);
+    if (height > 0) ImageBitmapScanline(row, span, bitmap, length, scale, invert);
+    for (int y = 1; y < height; y++)
+    {
+        memcpy(row + (size_t)y * span, row, span);
+    }
+    return size;
+}
+
+void OutputBarcodeImageBitmap(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    const size_t BLOCK_SIZE = 64 * 1024;
+    int width = (int)(length * scale);
+    int span = ((width + 31) / 32) * 4;
+    uint8_t header[BMP_HEADERSIZE + BMP_PAL_SIZE];
+    size_t size = ImageBitmapHeader(header, width, height, span, false);
+
+    // Smaller images are rendered whole, directly into the output
+    uint8_t *image = (size <= BLOCK_SIZE) ? OutputAppend(out, size) : NULL;
+    if (image != NULL)
+    {
+        OutputBarcodeImageBitmapMemory(image, size, bitmap, length, scale, height, invert);
+        return;
+    }
+
+    OutputWrite(out, header, sizeof(header));
+    if (height <= 0 || span <= 0) return;
+
+    // Bitmap data: a block of copies of the scanline is written repeatedly
+    int rowsPerBlock = (int)(BLOCK_SIZE / span);
+    if (rowsPerBlock < 1) rowsPerBlock = 1;
+    if (rowsPerBlock > height) rowsPerBlock = height;
+    uint8_t *block = (uint8_t *)malloc((size_t)rowsPerBlock * span);
+    out->allocations++;
+    if (block == NULL) { fprintf(stderr, "ERROR: Out of memory for bitmap rows.\n"); return; }
+    ImageBitmapScanline(block, span, bitmap, length, scale, invert);
+    for (int y = 1; y < rowsPerBlock; y++)
+    {
+        memcpy(block + (size_t)y * span, block, span);
+    }
+    for (int y = 0; y < height; y += rowsPerBlock)
+    {
+        int rows = (height - y < rowsPerBlock) ? (height - y) : rowsPerBlock;
+        OutputWrite(out, block, (size_t)span * rows);
+    }
+    free(block);
+}
+
+void OutputBitmapBegin(output_t *out, int width, int height)
+{
+    uint8_t header[BMP_HEADERSIZE + BMP_PAL_SIZE];
+    ImageBitmapHeader(header, width, height, OUTPUT_BITMAP_SPAN(width), true);
+    OutputWrite(out, header, sizeof(header));
+}
+
+void OutputBitmapRow(output_t *out, int width, const uint8_t *row)
+{
+    OutputWrite(out, row, OUTPUT_BITMAP_SPAN(width));
+}
+
+// Tiny 5x7 font for printable ASCII (from space), one byte per column (top row in bit 0)
+static const uint8_t fontGlyphs[95][5] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, // space ! " #
+    { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, // $ % & '
+    { 0x00, 0x1c, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x14, 0x08, 0x3e, 0x08, 0x14 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 }, // ( ) * +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 }, // , - . /
+    { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 }, // 0 1 2 3
+    { 0x18, 0x14, 0x12, 0x7f, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 4 5 6 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 }, // 8 9 : ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, // < = > ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3e }, { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 }, // @ A B C
+    { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 }, { 0x3e, 0x41, 0x49, 0x49, 0x7a }, // D E F G
+    { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 }, // H I J K
+    { 0x7f, 0x40, 0x40, 0x40, 0x40 }, { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e }, // L M N O
+    { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 }, // P Q R S
+    { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f }, { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f }, // T U V W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 }, // X Y Z [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 }, // backslash ] ^ _
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, // ` a b c
+    { 0x38, 0x44, 0x44, 0x48, 0x7f }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x0c, 0x52, 0x52, 0x52, 0x3e }, // d e f g
+    { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3d, 0x00 }, { 0x7f, 0x10, 0x28, 0x44, 0x00 }, // h i j k
+    { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 }, { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, // l m n o
+    { 0x7c, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7c }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 }, // p q r s
+    { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c }, { 0x3c, 0x40, 0x30, 0x40, 0x3c }, // t u v w
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c }, { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, // x y z {
+    { 0x00, 0x00, 0x7f, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },                                   // | } ~
+};
+
+void OutputTextRow(uint8_t *row, size_t x, size_t limit, const char *text, size_t length, int scale, int y)
+{
+    int glyphRow = y / scale - (OUTPUT_FONT_HEIGHT - 7);  // (the glyphs are seven rows, below a gap)
+    if (scale <= 0 || glyphRow < 0 || glyphRow >= 7) return;
+    for (size_t i = 0; i < length; i++, x += (size_t)OUTPUT_FONT_WIDTH * scale)
+    {
+        unsigned char c = (unsigned char)text[i];
+        const uint8_t *glyph = fontGlyphs[(c >= 0x20 && c < 0x7f) ? c - 0x20 : '?' - 0x20];
+        for (int column = 0; column < 5; column++)
+        {
+            if (!((glyph[column] >> glyphRow) & 1)) continue;
+            for (size_t p = x + (size_t)column * scale; p < x + (size_t)(column + 1) * scale && p < limit; p++)
+            {
+                row[p >> 3] &= (uint8_t)~(0x80 >> (p & 7));
+            }
+        }
+    }
+}
+
+
+// PNG - CRC-32 (of the chunk type and data) using a 4-bit table
+static uint32_t PngCrc(uint32_t crc, const uint8_t *data, size_t length)
+{
+    static const uint32_t crcTable[16] =
+    {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crcTable[crc & 0x0f];
+        crc = (crc >> 4) ^ crcTable[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+// Big-endian long write (PNG byte order)
+static uint8_t *putlongbe(uint8_t *p, uint32_t v) { p[0] = (uint8_t)((v >> 24) & 0xff); p[1] = (uint8_t)((v >> 16) & 0xff); p[2] = (uint8_t)((v >> 8) & 0xff); p[3] = (uint8_t)((v >> 0) & 0xff); return p + 4; }
+
+static void PngChunk(output_t *out, const char *type, const uint8_t *data, size_t length)
+{
+    uint8_t header[8];
+    putlongbe(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = PngCrc(0, header + 4, 4);
+    crc = PngCrc(crc, data, length);
+    uint8_t footer[4];
+    putlongbe(footer, crc);
+    OutputWrite(out, header, sizeof(header));
+    OutputWrite(out, data, length);
+    OutputWrite(out, footer, sizeof(footer));
+}
+
+static void PngFlushData(output_png_t *png)
+{
+    if (png->idatLength > 0) PngChunk(png->out, "IDAT", png->idat, png->idatLength);
+    png->idatLength = 0;
+}
+
+// Deflate bits are packed least significant bit first, and whole bytes go to the IDAT data
+static void PngBits(output_png_t *png, uint32_t value, int count)
+{
+    png->bits |= (uint64_t)value << png->numBits;
+    png->numBits += count;
+    while (png->numBits >= 8)
+    {
+        if (png->idatLength >= sizeof(png->idat)) PngFlushData(png);
+        png->idat[png->idatLength++] = (uint8_t)png->bits;
+        png->bits >>= 8;
+        png->numBits -= 8;
+    }
+}
+
+// Huffman codes are sent most significant bit first
+static void PngCode(output_png_t *png, uint32_t code, int count)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < count; i++, code >>= 1) reversed = (reversed << 1) | (code & 1);
+    PngBits(png, reversed, count);
+}
+
+// Literal/length symbol with the fixed Huffman code
+static void PngSymbol(output_png_t *png, int symbol)
+{
+    if (symbol < 144) PngCode(png, 0x30 + symbol, 8);
+    else if (symbol < 256) PngCode(png, 0x190 + (symbol - 144), 9);
+    else if (symbol < 280) PngCode(png, symbol - 256, 7);
+    else PngCode(png, 0xc0 + (symbol - 280), 8);
+}
+
+// Back-reference of 3-258 bytes at a distance of 1-32768 bytes
+static void PngMatch(output_png_t *png, int length, int distance)
+{
+    static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    int l = (length >= 258) ? 28 : 0;   // (searching up, as other than the maximum length of long repeats, most matches are short, e.g. a row)
+    while (l < 28 && lengthBase[l + 1] <= length) l++;
+    PngSymbol(png, 257 + l);
+    PngBits(png, length - lengthBase[l], lengthExtra[l]);
+    int d = 0;
+    while (d < 29 && distanceBase[d + 1] <= distance) d++;
+    PngCode(png, d, 5);
+    PngBits(png, distance - distanceBase[d], distanceExtra[d]);
+}
+
+// Back-reference of any length (at least 3), as a sequence of matches
+static void PngCopy(output_png_t *png, size_t length, int distance)
+{
+    while (length > 0)
+    {
+        int count = (length > 258) ? 258 : (int)length;
+        if (length > 258 && length - 258 < 3) count = (int)length - 3;    // Leave a final match of the minimum length
+        PngMatch(png, count, distance);
+        length -= count;
+    }
+}
+
+// Literal data, with runs of the same byte as a back-reference to the previous byte
+static void PngLiterals(output_png_t *png, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; )
+    {
+        size_t run = 1;
+        while (i + run < length && data[i + run] == data[i]) run++;
+        PngSymbol(png, data[i]);
+        if (run > 3)
+        {
+            PngCopy(png, run - 1, 1);
+        }
+        else
+        {
+            for (size_t j = 1; j < run; j++) PngSymbol(png, data[i]);
+        }
+        i += run;
+    }
+}
+
+// Repeated rows are a single back-reference to the previous row (when within the deflate window)
+static void PngFlushRows(output_png_t *png)
+{
+    size_t span = png->rowBytes + 1;
+    if (png->pendingRows <= 0) return;
+    if (span <= 32768 && span * png->pendingRows >= 3)
+    {
+        PngCopy(png, span * png->pendingRows, (int)span);
+    }
+    else
+    {
+        for (int i = 0; i < png->pendingRows; i++) PngLiterals(png, png->previous, span);
+    }
+    png->pendingRows = 0;
+}
+
+void OutputPngBegin(output_png_t *png, output_t *out, int width, int height)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    memset(png, 0, offsetof(output_png_t, idat));
+    png->out = out;
+    png->width = width;
+    png->height = height;
+    png->rowBytes = ((size_t)width + 7) / 8;
+    png->adlerA = 1;
+    png->previous = (uint8_t *)malloc(2 * (png->rowBytes + 1));
+    out->allocations++;
+    if (png->previous == NULL) { fprintf(stderr, "ERROR: Out of memory for PNG rows.\n"); return; }
+    png->alternate = png->previous + png->rowBytes + 1;
+    png->previous[0] = 0;    // Filter type: none
+    png->alternate[0] = 0;
+
+    OutputWrite(out, signature, sizeof(signature));
+    uint8_t header[13];
+    uint8_t *p = header;
+    p = putlongbe(p, (uint32_t)width);
+    p = putlongbe(p, (uint32_t)height);
+    *p++ = 1;   // Bit depth
+    *p++ = 0;   // Color type: grayscale
+    *p++ = 0;   // Compression method: deflate
+    *p++ = 0;   // Filter method: adaptive (each row is type 'none')
+    *p++ = 0;   // Interlace method: none
+    PngChunk(out, "IHDR", header, sizeof(header));
+
+    // zlib header (deflate, 32 kB window, fastest), then a single final block using the fixed Huffman codes
+    png->idat[png->idatLength++] = 0x78;
+    png->idat[png->idatLength++] = 0x01;
+    PngBits(png, 1, 1);     // BFINAL
+    PngBits(png, 1, 2);     // BTYPE: fixed Huffman
+}
+
+void OutputPngRow(output_png_t *png, const uint8_t *row)
+{
+    const uint32_t ADLER_MOD = 65521;
+    size_t span = png->rowBytes + 1;
+    if (png->previous == NULL || png->rows >= png->height) return;
+    if (png->rows > 0 && !memcmp(png->previous + 1, row, png->rowBytes))
+    {
+        png->pendingRows++;
+    }
+    else
+    {
+        PngFlushRows(png);
+
+        // The previous row becomes the alternate, and a return to the old alternate row (e.g. the bars and spaces of a rotated barcode) is a back-reference to it
+        uint8_t *swap = png->alternate; png->alternate = png->previous; png->previous = swap;
+        uint32_t swapSum = png->alternateSum; png->alternateSum = png->rowSum; png->rowSum = swapSum;
+        swapSum = png->alternateWeightedSum; png->alternateWeightedSum = png->rowWeightedSum; png->rowWeightedSum = swapSum;
+        size_t distance = span * ((size_t)png->run + 1);
+        if (png->alternateValid && span >= 3 && distance <= 32768 && !memcmp(png->previous + 1, row, png->rowBytes))
+        {
+            PngCopy(png, span, (int)distance);
+        }
+        else
+        {
+            memcpy(png->previous + 1, row, png->rowBytes);    // (the row may have been packed in place, in what is now the alternate)
+            PngLiterals(png, png->previous, span);
+
+            // The row's contribution to the checksum is found once, so that repeats of the row are quick to add
+            uint32_t sum = 0, weightedSum = 0;
+            for (size_t i = 0; i < span; i++)
+            {
+                sum = (sum + png->previous[i]) % ADLER_MOD;
+                weightedSum = (weightedSum + sum) % ADLER_MOD;
+            }
+            png->rowSum = sum;
+            png->rowWeightedSum = weightedSum;
+        }
+        png->alternateValid = (png->rows > 0);
+        png->run = 0;
+    }
+    // Adler-32 of the uncompressed data
+    png->adlerB = (uint32_t)((png->adlerB + (uint64_t)(span % ADLER_MOD) * png->adlerA + png->rowWeightedSum) % ADLER_MOD);
+    png->adlerA = (png->adlerA + png->rowSum) % ADLER_MOD;
+    png->rows++;
+    png->run++;
+}
+
+void OutputPngRows(output_png_t *png, const uint8_t *row, int count)
+{
+    const uint64_t ADLER_MOD = 65521;
+    if (count <= 0 || png->previous == NULL || png->rows >= png->height) return;
+    OutputPngRow(png, row);
+    uint64_t repeats = (uint64_t)count - 1;
+    if (repeats > (uint64_t)(png->height - png->rows)) repeats = (uint64_t)(png->height - png->rows);
+    if (repeats == 0) return;
+
+    // The repeats are back-references to the row, and the checksum of n repeats: A' = A + n S, B' = B + n (span A + W) + span S n (n - 1) / 2
+    uint64_t span = (png->rowBytes + 1) % ADLER_MOD;
+    uint64_t n = repeats % ADLER_MOD;
+    uint64_t triangle = ((repeats & 1) ? (repeats % ADLER_MOD) * (((repeats - 1) / 2) % ADLER_MOD) : ((repeats / 2) % ADLER_MOD) * ((repeats - 1) % ADLER_MOD)) % ADLER_MOD;
+    uint64_t b = png->adlerB + n * ((span * png->adlerA + png->rowWeightedSum) % ADLER_MOD) + triangle * (span * png->rowSum % ADLER_MOD);
+    png->adlerB = (uint32_t)(b % ADLER_MOD);
+    png->adlerA = (uint32_t)((png->adlerA + n * png->rowSum) % ADLER_MOD);
+    png->pendingRows += (int)repeats;
+    png->rows += (int)repeats;
+    png->run += (int)repeats;
+}
+
+void OutputPngEnd(output_png_t *png)
+{
+    if (png->previous == NULL) return;
+    PngFlushRows(png);
+    PngSymbol(png, 256);    // End of block
+    PngBits(png, 0, (8 - png->numBits) & 7);
+    uint8_t adler[4];
+    putlongbe(adler, (png->adlerB << 16) | png->adlerA);
+    for (int i = 0; i < 4; i++) PngBits(png, adler[i], 8);
+    PngFlushData(png);
+    PngChunk(png->out, "IEND", NULL, 0);
+    free((png->previous < png->alternate) ? png->previous : png->alternate);    // (the start of the two rows' allocation)
+    png->previous = NULL;
+}
+
+void OutputBarcodePng(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    int width = (int)(length * scale);
+    if (width <= 0 || height <= 0) return;
+    output_png_t *png = (output_png_t *)malloc(sizeof(output_png_t));
+    out->allocations++;
+    if (png == NULL) { fprintf(stderr, "ERROR: Out of memory for PNG.\n"); return; }
+    OutputPngBegin(png, out, width, height);
+    if (png->previous != NULL)
+    {
+        // The scanline is packed once (in the writer's row buffer), and every row is the same
+        uint8_t *row = png->previous + 1;
+        ImageBitmapScanline(row, (int)png->rowBytes, bitmap, length, scale, invert);
+        png->previous[0] = 0;
+        OutputPngRows(png, row, height);
+    }
+    OutputPngEnd(png);
+    free(png);
+}
+
+// Streams the rows of a rotated image to a BMP (png NULL) or PNG: every row is the same unless in ladder orientation, where there are only two different rows (a bar or a space), repeated for each run of pixels along the barcode.
+// The BMP rows are written from a block of copies of each row.
+static void ImageRotatedRows(output_t *out, output_png_t *png, uint8_t *bitmap, size_t length, int scale, int height, bool invert, barcode_rotation_t rotation)
+{
+    const size_t BLOCK_SIZE = 32 * 1024;
+    bool ladder = (rotation == BARCODE_ROTATE_90 || rotation == BARCODE_ROTATE_270);
+    size_t pixels = length * scale;
+    int width = ladder ? height : (int)pixels;
+    int rows = ladder ? (int)pixels : height;
+    size_t span = OUTPUT_BITMAP_SPAN(width);
+    int blockRows = (png != NULL) ? 1 : (int)(BLOCK_SIZE / span);
+    if (blockRows < 1) blockRows = 1;
+    if (blockRows > rows) blockRows = rows;
+    size_t blockSize = (size_t)blockRows * span;
+    uint8_t *buffer = (uint8_t *)calloc(2 * blockSize + (pixels + 7) / 8, 1);
+    out->allocations++;
+    if (buffer == NULL) { fprintf(stderr, "ERROR: Out of memory for bitmap rows.\n"); return; }
+
+    // The single row (horizontal), or a row for a bar and a space (ladder), and the barcode as a row of pixels to choose between them
+    uint8_t *block[2] = { buffer, buffer + blockSize };    // Bar (or horizontal), space
+    uint8_t *line = buffer + 2 * blockSize;
+    if (ladder)
+    {
+        RowSetBits(block[invert ? 0 : 1], 0, (size_t)width);
+        BarcodeRasterize(line, 0, BARCODE_RASTER_1BPP, 0, 0, bitmap, length, scale, 0, 1, false);
+    }
+    else
+    {
+        BarcodeRasterizeRotated(block[0], span, BARCODE_RASTER_1BPP, 0, 0, bitmap, length, scale, 0, 1, invert, rotation);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        for (int y = 1; y < blockRows; y++) memcpy(block[i] + (size_t)y * span, block[i], span);
+    }
+
+    for (int y = 0; y < rows; )
+    {
+        // The run of rows the same as this one
+        int count = rows - y;
+        bool space = false;
+        if (ladder)
+        {
+            size_t p = (rotation == BARCODE_ROTATE_90) ? (size_t)y : pixels - 1 - y;
+            space = ((line[p >> 3] << (p & 7)) & 0x80) != 0;
+            for (count = 1; y + count < rows; count++)
+            {
+                size_t q = (rotation == BARCODE_ROTATE_90) ? p + count : p - count;
+                if ((((line[q >> 3] << (q & 7)) & 0x80) != 0) != space) break;
+            }
+        }
+        if (png != NULL) OutputPngRows(png, block[space ? 1 : 0], count);
+        for (int written = 0; png == NULL && written < count; written += blockRows)
+        {
+            OutputWrite(out, block[space ? 1 : 0], span * ((count - written < blockRows) ? count - written : blockRows));
+        }
+        y += count;
+    }
+    free(buffer);
+}
+
+void OutputBarcodeImageBitmapRotated(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert, barcode_rotation_t rotation)
+{
+    const size_t BLOCK_SIZE = 64 * 1024;
+    bool ladder = (rotation == BARCODE_ROTATE_90 || rotation == BARCODE_ROTATE_270);
+    int width = ladder ? height : (int)(length * scale);
+    int rows = ladder ? (int)(length * scale) : height;
+    if (width <= 0 || rows <= 0) return;
+    int span = (int)OUTPUT_BITMAP_SPAN(width);
+    uint8_t header[BMP_HEADERSIZE + BMP_PAL_SIZE];
+    size_t size = ImageBitmapHeader(header, width, rows, span, true);
+
+    // Smaller images are rasterized whole, directly into the output (cleared first, for the padding)
+    uint8_t *image = (size <= BLOCK_SIZE) ? OutputAppend(out, size) : NULL;
+    if (image != NULL)
+    {
+        memcpy(image, header, sizeof(header));
+        memset(image + sizeof(header), 0, size - sizeof(header));
+        BarcodeRasterizeRotated(image + sizeof(header), span, BARCODE_RASTER_1BPP, 0, 0, bitmap, length, scale, 0, height, invert, rotation);
+        return;
+    }
+    OutputWrite(out, header, sizeof(header));
+    ImageRotatedRows(out, NULL, bitmap, length, scale, height, invert, rotation);
+}
+
+void OutputBarcodePngRotated(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert, barcode_rotation_t rotation)
+{
+    bool ladder = (rotation == BARCODE_ROTATE_90 || rotation == BARCODE_ROTATE_270);
+    int width = ladder ? height : (int)(length * scale);
+    int rows = ladder ? (int)(length * scale) : height;
+    if (width <= 0 || rows <= 0) return;
+    output_png_t *png = (output_png_t *)malloc(sizeof(output_png_t));
+    out->allocations++;
+    if (png == NULL) { fprintf(stderr, "ERROR: Out of memory for PNG.\n"); return; }
+    OutputPngBegin(png, out, width, rows);
+    if (png->previous != NULL) ImageRotatedRows(out, png, bitmap, length, scale, height, invert, rotation);
+    OutputPngEnd(png);
+    free(png);
+}
+
+
+#define VECTOR_CHUNK 2048   // Modules of the bitmap converted to run widths at a time (a multiple of 8, so each chunk starts on a byte, and short enough for the 16-bit widths)
+
+// The bars of a bitmap, from its run widths (found a byte at a time), rather than module by module
+typedef struct
+{
+    const uint8_t *bitmap;
+    size_t length;
+    size_t next;            // Start of the next chunk
+    size_t position;        // Start of the next run
+    size_t run;             // Next run of the chunk
+    size_t numRuns;
+    uint16_t runs[VECTOR_CHUNK + 1];
+} vector_bars_t;
+
+static void VectorBarsInit(vector_bars_t *bars, const uint8_t *bitmap, size_t length)
+{
+    bars->bitmap = bitmap;
+    bars->length = length;
+    bars->next = 0;
+    bars->position = 0;
+    bars->run = 0;
+    bars->numRuns = 0;
+}
+
+// The next run (alternately space and bar within each chunk, which starts with a possibly zero-width space), returns false at the end
+static bool VectorRun(vector_bars_t *bars, bool *bar, size_t *width)
+{
+    while (bars->run >= bars->numRuns)
+    {
+        if (bars->next >= bars->length) return false;
+        size_t chunkLength = (bars->length - bars->next < VECTOR_CHUNK) ? bars->length - bars->next : VECTOR_CHUNK;
+        bars->numRuns = BarcodeBitmapRuns(bars->runs, VECTOR_CHUNK + 1, bars->bitmap + (bars->next >> 3), chunkLength);
+        bars->run = 0;
+        bars->next += chunkLength;
+    }
+    *bar = (bars->run & 1) != 0;
+    *width = bars->runs[bars->run++];
+    return true;
+}
+
+// Finds the next bar (run of black modules), joining a bar split between chunks, returns false when there are no more
+static bool VectorNextBar(vector_bars_t *bars, size_t *start, size_t *width)
+{
+    bool bar;
+    size_t run;
+    do
+    {
+        if (!VectorRun(bars, &bar, &run)) return false;
+        bars->position += run;
+    } while (!bar);
+    *start = bars->position - run;
+    *width = run;
+    while (VectorRun(bars, &bar, &run))
+    {
+        bars->position += run;
+        if (!bar && run > 0) break;     // (a zero-width space starts the next chunk, so the bar continues)
+        *width += run;
+    }
+    return true;
+}
+
+// SVG with the coordinates in modules, and the physical size from the module size (millimeters), one rectangle per bar
+void OutputBarcodeSvg(output_t *out, uint8_t *bitmap, size_t length, double moduleSize, int height, bool invert)
+{
+    OutputPrintf(out, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%gmm\" height=\"%gmm\" viewBox=\"0 0 %u %d\" shape-rendering=\"crispEdges\">\n", moduleSize * length, moduleSize * height, (unsigned int)length, height);
+    OutputPrintf(out, "<rect width=\"%u\" height=\"%d\" fill=\"%s\"/>\n", (unsigned int)length, height, invert ? "#000" : "#fff");
+    OutputPrintf(out, "<path fill=\"%s\" d=\"", invert ? "#fff" : "#000");
+    vector_bars_t bars;
+    VectorBarsInit(&bars, bitmap, length);
+    size_t start, width;
+    while (VectorNextBar(&bars, &start, &width))
+    {
+        OutputPrintf(out, "M%u 0h%uv%dh-%uz", (unsigned int)start, (unsigned int)width, height, (unsigned int)width);
+    }
+    OutputPrintf(out, "\"/>\n</svg>\n");
+}
+
+// Single-page PDF the size of the barcode, the page is scaled so the coordinates are in modules, one rectangle per bar
+void OutputBarcodePdf(output_t *out, uint8_t *bitmap, size_t length, double moduleSize, int height, bool invert)
+{
+    double modulePoints = moduleSize * 72.0 / 25.4;
+
+    // The content stream is built first, as its length is required
+    output_t content;
+    OutputInit(&content, NULL);
+    OutputPrintf(&content, "%g 0 0 %g 0 0 cm\n%d g\n0 0 %u %d re f\n%d g\n", modulePoints, modulePoints, invert ? 0 : 1, (unsigned int)length, height, invert ? 1 : 0);
+    vector_bars_t bars;
+    VectorBarsInit(&bars, bitmap, length);
+    size_t start, width;
+    while (VectorNextBar(&bars, &start, &width))
+    {
+        OutputPrintf(&content, "%u 0 %u %d re\n", (unsigned int)start, (unsigned int)width, height);
+    }
+    OutputPrintf(&content, "f\n");
+
+    // The document is collected in memory for the cross-reference offsets
+    output_t doc;
+    OutputInit(&doc, NULL);
+    size_t offsets[4];
+    OutputPrintf(&doc, "%%PDF-1.4\n");
+    offsets[0] = doc.length;
+    OutputPrintf(&doc, "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    offsets[1] = doc.length;
+    OutputPrintf(&doc, "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+    offsets[2] = doc.length;
+    OutputPrintf(&doc, "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.3f %.3f] /Resources << >> /Contents 4 0 R >>\nendobj\n", modulePoints * length, modulePoints * height);
+    offsets[3] = doc.length;
+    OutputPrintf(&doc, "4 0 obj\n<< /Length %u >>\nstream\n", (unsigned int)content.length);
+    OutputWrite(&doc, content.buffer, content.length);
+    OutputPrintf(&doc, "endstream\nendobj\n");
+    size_t xref = doc.length;
+    OutputPrintf(&doc, "xref\n0 5\n0000000000 65535 f \n");
+    for (int i = 0; i < 4; i++)
+    {
+        OutputPrintf(&doc, "%010u 00000 n \n", (unsigned int)offsets[i]);
+    }
+    OutputPrintf(&doc, "trailer\n<< /Size 5 /Root 1 0 R >>\nstartxref\n%u\n%%%%EOF\n", (unsigned int)xref);
+
+    if (content.error || doc.error) fprintf(stderr, "ERROR: Out of memory for PDF.\n");
+    else OutputWrite(out, doc.buffer, doc.length);
+    out->allocations += content.allocations + doc.allocations;
+    OutputFree(&content);
+    OutputFree(&doc);
+}
+
+
+// Sixel characters for a run of pixel columns, with the repeat introducer for longer runs
+static void SixelRun(output_t *out, int value, size_t count)
+{
+    char c = (char)(value + 63);
+    if (count > 3)
+    {
+        OutputPrintf(out, "!%u%c", (unsigned int)count, c);
+    }
+    else
+    {
+        uint8_t *p = OutputAppend(out, count);
+        if (p != NULL) memset(p, c, count);
+    }
+}
+
+// One band of (up to) six rows: as every row is the same, each pass is just the runs of bars in one color
+static void SixelBand(output_t *out, uint8_t *bitmap, size_t length, int scale, bool invert, int rows)
+{
+    const int passes = 2;
+    int mask = (1 << rows) - 1;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        // Start a pass in a specific color
+        OutputPrintf(out, "#%d", pass);
+        size_t skipped = 0;     // Columns not drawn in this pass are only output if followed by drawn columns
+        for (size_t i = 0; i < length; )
+        {
+            int bitValue = (BARCODE_BIT(bitmap, i) ^ invert) ? 1 : 0;
+            size_t start = i;
+            while (++i < length && ((BARCODE_BIT(bitmap, i) ^ invert) ? 1 : 0) == bitValue) { }
+            size_t count = (i - start) * scale;
+            if (bitValue == pass)
+            {
+                if (skipped > 0) SixelRun(out, 0, skipped);
+                skipped = 0;
+                SixelRun(out, mask, count);
+            }
+            else
+            {
+                skipped += count;
+            }
+        }
+        // Return to start of the line
+        if (pass + 1 < passes) {
+            OutputPrintf(out, "$");
+        }
+    }
+}
+
+void OutputBarcodeSixel(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    const int LINE_HEIGHT = 6;
+    // Enter sixel mode
+    OutputPrintf(out, "\x1BP7;1q");    // 1:1 ratio, 0 pixels remain at current color
+    // Set color map
+    OutputPrintf(out, "#0;2;0;0;0");       // Background
+    OutputPrintf(out, "#1;2;100;100;100");
+
+    // Every full band is identical, so it is encoded once and repeated (followed by the shorter final band, if any)
+    int fullBands = height / LINE_HEIGHT;
+    int remainingRows = height % LINE_HEIGHT;
+    if (fullBands > 0)
+    {
+        output_t band;
+        OutputInit(&band, NULL);
+        SixelBand(&band, bitmap, length, scale, invert, LINE_HEIGHT);
+        for (int y = 0; y < fullBands; y++)
+        {
+            OutputWrite(out, band.buffer, band.length);
+            // Next line
+            if (y + 1 < fullBands || remainingRows > 0) {
+                OutputWrite(out, "-", 1);
+            }
+        }
+        out->allocations += band.allocations;
+        OutputFree(&band);
+    }
+    if (remainingRows > 0)
+    {
+        SixelBand(out, bitmap, length, scale, invert, remainingRows);
+    }
+
+    // Exit sixel mode
+    OutputPrintf(out, "\x1B\\");
+    OutputPrintf(out, "\n");
+}
+
+
+// TGP - Terminal Graphics Protocol
+void OutputBarcodeTerminalGraphicsProtocol(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    // The image is sent as a PNG (f=100), which is only a few hundred bytes as the rows are compressed to back-references
+    output_t image;
+    OutputInit(&image, NULL);
+    OutputBarcodePng(&image, bitmap, length, scale, height, invert);
+    out->allocations += image.allocations;
+
+    // Chunked output, each chunk is encoded to Base64 directly into the output
+    const size_t MAX_CHUNK_SIZE = 4096;
+    const size_t chunkInput = MAX_CHUNK_SIZE / 4 * 3;
+    const char *base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t i = 0; i < image.length && !image.error; i += chunkInput)
+    {
+        size_t inputSize = (i + chunkInput < image.length) ? chunkInput : (image.length - i);
+        const uint8_t *data = image.buffer + i;
+        int nonTerminal = (i + chunkInput < image.length) ? 1 : 0;
+        if (i == 0) {
+            // action transmit and display (a=T), direct transfer (t=d), PNG data (f=100), no responses at all (q=2)
+            OutputPrintf(out, "\x1B_Ga=T,f=100,t=d,q=2,m=%d;", nonTerminal);
+        } else {
+            OutputPrintf(out, "\x1B_Gm=%d;", nonTerminal);
+        }
+        char *p = (char *)OutputAppend(out, ((inputSize + 2) / 3) * 4);
+        if (p == NULL) break;
+        for (size_t j = 0; j < inputSize; j += 3)
+        {
+            uint32_t value = (data[j] << 16) | (j + 1 < inputSize ? (data[j + 1] << 8) : 0) | (j + 2 < inputSize ? data[j + 2] : 0);
+            *p++ = base64Chars[(value >> 18) & 0x3f];
+            *p++ = base64Chars[(value >> 12) & 0x3f];
+            *p++ = (j + 1 < inputSize) ? base64Chars[(value >> 6) & 0x3f] : '=';
+            *p++ = (j + 2 < inputSize) ? base64Chars[value & 0x3f] : '=';
+        }
+        OutputPrintf(out, "\x1B\\");
+    }
+    OutputPrintf(out, "\n");
+    OutputFree(&image);
+}
+
+
+// ZPL - the label as a graphic field (^GF, 1=black) of ASCII hex with the printer's compression: a repeat count before a hex digit ('G'-'Y' are 1-19, 'g'-'z' are 20-400 in twenties, summed), ',' to fill the rest of the row with 0 (white), '!' with 1 (black), and ':' to repeat the previous row
+static char *ZplRow(char *p, const uint8_t *row, size_t rowBytes)
+{
+    const char *hexChars = "0123456789ABCDEF";
+    const size_t MAX_COUNT = 419;   // (the largest of a single pair of count characters)
+    size_t nibbles = rowBytes * 2;
+    for (size_t i = 0; i < nibbles; )
+    {
+        int nibble = (row[i >> 1] >> ((i & 1) ? 0 : 4)) & 0x0f;
+        size_t run = 1;
+        while (i + run < nibbles && ((row[(i + run) >> 1] >> (((i + run) & 1) ? 0 : 4)) & 0x0f) == nibble) run++;
+        i += run;
+        if (i == nibbles && (nibble == 0x0 || nibble == 0xf)) { *p++ = nibble ? '!' : ','; break; }
+        while (run > 0)
+        {
+            size_t count = (run > MAX_COUNT) ? MAX_COUNT : run;
+            if (count >= 20) *p++ = (char)('g' + count / 20 - 1);
+            if (count > 1 && count % 20 > 0) *p++ = (char)('G' + count % 20 - 1);
+            *p++ = hexChars[nibble];
+            run -= count;
+        }
+    }
+    return p;
+}
+
+void OutputBarcodeZpl(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    size_t rowBytes = (length * scale + 7) / 8;
+    if (height <= 0 || rowBytes == 0) return;
+
+    // Every row of the barcode is the same, so the field is a single compressed row followed by a repeat for each of the others
+    uint8_t *row = (uint8_t *)malloc(rowBytes + 2 * rowBytes);     // (the encoding is at most one character per hex digit, as a count covers at least two)
+    out->allocations++;
+    if (row == NULL) { fprintf(stderr, "ERROR: Out of memory for ZPL row.\n"); return; }
+    ImageBitmapScanline(row, (int)rowBytes, bitmap, length, scale, !invert);
+    char *encoded = (char *)row + rowBytes;
+    size_t encodedLength = (size_t)(ZplRow(encoded, row, rowBytes) - encoded);
+
+    // Label start, field origin, then the graphic field: ASCII hex, total bytes, graphic field count, bytes per row, data
+    OutputPrintf(out, "^XA\n^FO0,0^GFA,%lu,%lu,%lu,", (unsigned long)(rowBytes * height), (unsigned long)(rowBytes * height), (unsigned long)rowBytes);
+    OutputWrite(out, encoded, encodedLength);
+    static const char repeats[] = "::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::";
+    for (int y = 1; y < height; )
+    {
+        int count = (height - y < (int)sizeof(repeats) - 1) ? height - y : (int)sizeof(repeats) - 1;
+        OutputWrite(out, repeats, count);
+        y += count;
+    }
+    OutputPrintf(out, "^FS\n^XZ\n");
+    free(row);
+}
+
+// EPL - the label as a binary graphic (GW, 0=black), which has no compression, but is the packed bitmap rows as-is
+void OutputBarcodeEpl(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert)
+{
+    const size_t BLOCK_SIZE = 64 * 1024;
+    size_t width = length * scale;
+    size_t rowBytes = (width + 7) / 8;
+    if (height <= 0 || rowBytes == 0) return;
+
+    // Clear the image buffer, then the graphic at the origin: bytes per row, rows, data
+    OutputPrintf(out, "\nN\nGW0,0,%lu,%d,", (unsigned long)rowBytes, height);
+
+    // A block of copies of the row is written repeatedly (with the padding of the final byte white)
+    int rowsPerBlock = (int)(BLOCK_SIZE / rowBytes);
+    if (rowsPerBlock < 1) rowsPerBlock = 1;
+    if (rowsPerBlock > height) rowsPerBlock = height;
+    uint8_t *block = (uint8_t *)malloc((size_t)rowsPerBlock * rowBytes);
+    out->allocations++;
+    if (block == NULL) { fprintf(stderr, "ERROR: Out of memory for EPL rows.\n"); return; }
+    ImageBitmapScanline(block, (int)rowBytes, bitmap, length, scale, invert);
+    RowSetBits(block, width, rowBytes * 8 - width);
+    for (int y = 1; y < rowsPerBlock; y++)
+    {
+        memcpy(block + (size_t)y * rowBytes, block, rowBytes);
+    }
+    for (int y = 0; y < height; y += rowsPerBlock)
+    {
+        int count = (height - y < rowsPerBlock) ? height - y : rowsPerBlock;
+        OutputWrite(out, block, (size_t)count * rowBytes);
+    }
+    free(block);
+
+    // Print one label
+    OutputPrintf(out, "\nP1\n");
+}
@@ -0,0 +1,124 @@
+// Barcode - Output renderers for the demonstration program
+// Dan Jackson, 2019
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "barcode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Renderer output: collected in a (growable) memory buffer, and written to a file (if any) whenever it fills
+typedef struct
+{
+    FILE *fp;           // File to write to (NULL to collect everything in memory)
+    uint8_t *buffer;
+    size_t capacity;
+    size_t length;
+    bool error;         // Out of memory
+    size_t allocations; // Number of allocations made for this output (by the buffer and renderers)
+    uint64_t written;   // Bytes written to the file
+    bool timed;         // Measure the time spent writing to the file (unless built with NO_STATS)
+    double writeTime;   // Seconds
+} output_t;
+
+#define OUTPUT_FILE_BUFFER (64 * 1024)
+
+// Monotonic time in seconds
+double OutputTime(void);
+
+// Initialize the output to write to a file, or (if NULL) to collect everything in memory
+void OutputInit(output_t *out, FILE *fp);
+
+// Write any buffered output to the file
+void OutputFlush(output_t *out);
+
+// Flush and free the output buffer
+void OutputFree(output_t *out);
+
+// Returns space for the specified number of bytes at the end of the output (flushing or growing as required), or NULL if unavailable (larger than the file buffer, or out of memory)
+uint8_t *OutputAppend(output_t *out, size_t size);
+
+// Write data or formatted text to the output
+void OutputWrite(output_t *out, const void *data, size_t size);
+void OutputPrintf(output_t *out, const char *format, ...);
+
+// Renderers for the bitmap (0=black, 1=white) of the specified length in bars/bits from Barcode()
+void OutputBarcodeInfo(output_t *out, uint8_t *bitmap, size_t length, const char *input, size_t inputLength);
+void OutputBarcodeTextWide(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeTextNarrow(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeImageBitmap(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeSixel(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeTerminalGraphicsProtocol(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeZpl(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+void OutputBarcodeEpl(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+
+// BMP writer: 1-bit (0=black) rows are streamed in from the top (a top-down bitmap, with a negative height), each row packed most significant bit first in a buffer of OUTPUT_BITMAP_SPAN() bytes (the padding is written as it is)
+#define OUTPUT_BITMAP_SPAN(_width) ((((size_t)(_width) + 31) / 32) * 4)
+void OutputBitmapBegin(output_t *out, int width, int height);
+void OutputBitmapRow(output_t *out, int width, const uint8_t *row);
+
+// Human-readable text in a tiny 5x7 font: each character is OUTPUT_FONT_WIDTH by OUTPUT_FONT_HEIGHT pixels at a scale of 1 (including the gap to the next character, and a gap above)
+#define OUTPUT_FONT_WIDTH 6
+#define OUTPUT_FONT_HEIGHT 8
+
+// Draws row y (0 to OUTPUT_FONT_HEIGHT * scale - 1) of a line of text as black pixels in a 1-bit row (most significant bit first, 0=black), from pixel x and clipped before the pixel limit, characters other than printable ASCII are drawn as '?'
+void OutputTextRow(uint8_t *row, size_t x, size_t limit, const char *text, size_t length, int scale, int y);
+
+// PNG writer: 1-bit grayscale (0=black) rows are streamed in, compressed with a built-in fixed-Huffman deflate, where repeated rows become back-references
+#define OUTPUT_PNG_IDAT_SIZE 8192
+typedef struct
+{
+    output_t *out;
+    int width;
+    int height;
+    size_t rowBytes;    // Bytes per packed row (excluding the filter type byte)
+    int rows;           // Rows written so far
+    int pendingRows;    // Rows identical to the previous row not yet compressed
+    uint8_t *previous;  // Filter type byte and the previous row
+    uint32_t rowSum;    // Adler-32 contributions of the previous row (for repeated rows)
+    uint32_t rowWeightedSum;
+    uint8_t *alternate; // The row before the run of the previous row (for rows alternating between two patterns), and its contributions
+    uint32_t alternateSum;
+    uint32_t alternateWeightedSum;
+    bool alternateValid;
+    int run;            // Rows in the run of the previous row
+    uint32_t adlerA;
+    uint32_t adlerB;
+    uint64_t bits;      // Deflate bit accumulator (least significant bit first)
+    int numBits;
+    size_t idatLength;
+    uint8_t idat[OUTPUT_PNG_IDAT_SIZE]; // Compressed data for the next IDAT chunk
+} output_png_t;
+
+// Starts a PNG image of the specified size (both greater than zero), then each of the 'height' rows must be added (most significant bit first, padded to a whole byte) before ending the image
+void OutputPngBegin(output_png_t *png, output_t *out, int width, int height);
+void OutputPngRow(output_png_t *png, const uint8_t *row);
+void OutputPngRows(output_png_t *png, const uint8_t *row, int count);      // The same row repeated
+void OutputPngEnd(output_png_t *png);
+
+void OutputBarcodePng(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+
+// Rotated BMP (stored top-down) and PNG images, where the ladder orientation (90 or 270 degrees clockwise) is 'height' pixels wide, and each row a single bar or space
+void OutputBarcodeImageBitmapRotated(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert, barcode_rotation_t rotation);
+void OutputBarcodePngRotated(output_t *out, uint8_t *bitmap, size_t length, int scale, int height, bool invert, barcode_rotation_t rotation);
+
+// Vector renderers (one rectangle per bar) for the module size in millimeters, and the height in modules
+void OutputBarcodeSvg(output_t *out, uint8_t *bitmap, size_t length, double moduleSize, int height, bool invert);
+void OutputBarcodePdf(output_t *out, uint8_t *bitmap, size_t length, double moduleSize, int height, bool invert);
+
+// Writes the BMP image to a memory buffer, returns the size of the image (nothing is written if the buffer is too small, e.g. NULL to query the size)
+size_t OutputBarcodeImageBitmapMemory(uint8_t *buffer, size_t bufferSize, uint8_t *bitmap, size_t length, int scale, int height, bool invert);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif